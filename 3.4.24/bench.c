@@ -0,0 +1,408 @@
+/*
+FRACTAL - A program growing fractals to benchmark parallelization and drawing
+libraries.
+
+Copyright 2009-2025, Javier Burguete Tolosa.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY Javier Burguete Tolosa ``AS IS'' AND ANY EXPRESS
+OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+EVENT SHALL Javier Burguete Tolosa OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * \file bench.c
+ * \brief Source file to define the benchmark functions.
+ * \author Javier Burguete Tolosa.
+ * \copyright Copyright 2009-2025, Javier Burguete Tolosa.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <gsl/gsl_rng.h>
+#include <glib.h>
+#include <libintl.h>
+#include <gtk/gtk.h>
+#include "config2.h"
+#include "fractal.h"
+#include "simulator.h"
+#include "perf.h"
+#include "bench.h"
+
+static volatile unsigned long bench_sink;
+///< Sink of the random draws, keeping the timed loops of the microbenchmark.
+static double bench_nsteps;     ///< Walker steps of the measured runs.
+static double bench_npoints;    ///< Fractal points of the measured runs.
+#if HAVE_PERF_EVENT
+static double bench_count[N_PERF_EVENTS];
+///< Hardware performance counters of the measured runs.
+#endif
+
+/**
+ * Function to calculate the mean and the sample variance of a set of values.
+ */
+static void
+bench_statistics (double *x,    ///< Array of values.
+                  unsigned int n,       ///< Number of values.
+                  double *mean, ///< Mean.
+                  double *variance)     ///< Sample variance.
+{
+  double m, v;
+  unsigned int i;
+  for (i = 0, m = 0.; i < n; ++i)
+    m += x[i];
+  m /= n;
+  for (i = 0, v = 0.; i < n; ++i)
+    v += (x[i] - m) * (x[i] - m);
+  if (n > 1)
+    v /= n - 1;
+  *mean = m;
+  *variance = v;
+}
+
+/**
+ * Function to run the warm-up and the measured runs of a fractal
+ * configuration, saving the times, the steps/s and the points/s of the
+ * measured runs and adding their walker steps, points and hardware
+ * performance counters.
+ */
+static void
+bench_measure (double *time,    ///< Array of times.
+               double *steps,   ///< Array of steps/s.
+               double *points,  ///< Array of points/s.
+               unsigned int warmup,     ///< Number of warm-up runs.
+               unsigned int repetitions)        ///< Number of measured runs.
+{
+  unsigned int i;
+#if HAVE_PERF_EVENT
+  unsigned int j;
+  for (j = 0; j < N_PERF_EVENTS; ++j)
+    bench_count[j] = 0.;
+#endif
+  for (i = 0; i < warmup; ++i)
+    fractal ();
+  for (i = 0, bench_nsteps = bench_npoints = 0.; i < repetitions; ++i)
+    {
+      fractal ();
+      time[i] = fractal_time;
+      steps[i] = walker_steps / fractal_time;
+      points[i] = fractal_points () / fractal_time;
+      bench_nsteps += walker_steps;
+      bench_npoints += fractal_points ();
+#if HAVE_PERF_EVENT
+      if (perf)
+        for (j = 0; j < N_PERF_EVENTS; ++j)
+          bench_count[j] += perf_total[j];
+#endif
+    }
+}
+
+/**
+ * Function to run a benchmark of a fractal configuration.
+ */
+static void
+bench_run (FILE *file,          ///< Benchmark table file.
+           unsigned int warmup, ///< Number of warm-up runs.
+           unsigned int repetitions)    ///< Number of measured runs.
+{
+  double time[repetitions], steps[repetitions], points[repetitions];
+  double time_mean, time_variance, steps_mean, steps_variance, points_mean,
+    points_variance;
+#if HAVE_PERF_EVENT
+  unsigned int j;
+#endif
+#if DEBUG
+  printf ("bench_run: type=%u 3D=%u diagonal=%u random=%u\n",
+          fractal_type, fractal_3D, fractal_diagonal, random_algorithm);
+#endif
+  bench_measure (time, steps, points, warmup, repetitions);
+  bench_statistics (time, repetitions, &time_mean, &time_variance);
+  bench_statistics (steps, repetitions, &steps_mean, &steps_variance);
+  bench_statistics (points, repetitions, &points_mean, &points_variance);
+  fprintf (file, "%s\t%u\t%u\t%s\t%u\t%u\t%u\t%u\t%u\t%.0f\t%.0f\t%.6f\t%g"
+           "\t%g\t%g\t%g\t%g",
+           fractal_type_name[fractal_type], fractal_3D, fractal_diagonal,
+           random_type_name[random_algorithm], nthreads, width, height,
+           length, repetitions, bench_npoints / repetitions,
+           bench_nsteps / repetitions,
+           time_mean, time_variance, steps_mean, steps_variance,
+           points_mean, points_variance);
+#if HAVE_PERF_EVENT
+  if (perf)
+    {
+      for (j = 0; j < N_PERF_EVENTS; ++j)
+        if (perf_available & (1 << j) && bench_nsteps > 0.)
+          fprintf (file, "\t%g", bench_count[j] / bench_nsteps);
+        else
+          fprintf (file, "\t-");
+    }
+#endif
+  fprintf (file, "\n");
+  fflush (file);
+}
+
+/**
+ * Function to run the benchmark of all the fractal types, 2D and 3D media,
+ * movements and pseudo-random number generators, saving a table of
+ * throughputs and times separated by tabulators.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+bench (char *filename,          ///< Benchmark table file name.
+       unsigned int sized,
+       ///< 1 on using the medium sizes of an input file, 0 on default sizes.
+       unsigned int warmup,     ///< Number of warm-up runs.
+       unsigned int repetitions)        ///< Number of measured runs.
+{
+  FILE *file;
+#if HAVE_PERF_EVENT
+  unsigned int i;
+#endif
+  file = fopen (filename, "w");
+  if (!file)
+    {
+      show_error (_("Unable to open the benchmark file"));
+      return 0;
+    }
+  fprintf (file, "type\tiii-d\tdiagonal\trandom-type\tthreads\twidth\theight"
+           "\tlength\trepetitions\tpoints\tsteps\ttime\ttime-variance"
+           "\tsteps/s\tsteps/s-variance\tpoints/s\tpoints/s-variance");
+#if HAVE_PERF_EVENT
+  if (perf)
+    for (i = 0; i < N_PERF_EVENTS; ++i)
+      fprintf (file, "\t%s/step", perf_event_name[i]);
+#endif
+  fprintf (file, "\n");
+  animating = 0;
+  random_seed_type = RANDOM_SEED_TYPE_FIXED;
+  for (fractal_type = 0; fractal_type < N_FRACTAL_TYPES; ++fractal_type)
+    for (fractal_3D = 0; fractal_3D < 2; ++fractal_3D)
+      {
+        if (!sized)
+          {
+            if (fractal_3D)
+              width = height = length = BENCH_SIZE_3D;
+            else
+              width = height = length = BENCH_SIZE_2D;
+          }
+        for (fractal_diagonal = 0; fractal_diagonal < 2; ++fractal_diagonal)
+          for (random_algorithm = 0; random_algorithm < N_RANDOM_TYPES;
+               ++random_algorithm)
+            bench_run (file, warmup, repetitions);
+      }
+  fclose (file);
+  return 1;
+}
+
+/**
+ * Function to run a strong or weak scaling sweep of the input fractal for 1,
+ * 2, 4, ... threads up to the input threads number, ending always with the
+ * input threads number. On weak scaling the medium volume grows
+ * proportionally to the threads number, stopping the sweep if the medium
+ * sizes exceed MEDIUM_MAX. It saves a table
+ * of times, throughputs, speedups, parallel efficiencies and Karp-Flatt
+ * serial fractions separated by tabulators. Every threads number is also run
+ * switching the cache isolation of the walkers, saving the steps/s without
+ * and with it.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+bench_scaling (char *filename,  ///< Scaling table file name.
+               unsigned int weak,       ///< 1 on weak scaling, 0 on strong.
+               unsigned int warmup,     ///< Number of warm-up runs.
+               unsigned int repetitions)        ///< Number of measured runs.
+{
+  double time[repetitions], steps[repetitions], points[repetitions],
+    time_switched[repetitions], steps_switched[repetitions];
+  double time_mean, time_variance, steps_mean, steps_variance, time_1,
+    steps_1, speedup, efficiency, serial, factor, switched_mean,
+    switched_variance;
+  FILE *file;
+  long int sw, sh, sl;
+  unsigned int p, n, w, h, l, isolation;
+  file = fopen (filename, "w");
+  if (!file)
+    {
+      show_error (_("Unable to open the scaling file"));
+      return 0;
+    }
+  fprintf (file, "threads\twidth\theight\tlength\ttime\ttime-variance"
+           "\tsteps/s\tsteps/s-variance\tspeedup\tefficiency\tkarp-flatt"
+           "\tsteps/s-shared\tsteps/s-isolated\n");
+  animating = 0;
+  random_seed_type = RANDOM_SEED_TYPE_FIXED;
+  isolation = cache_isolation;
+  n = nthreads;
+  w = width;
+  h = height;
+  l = length;
+  time_1 = steps_1 = 0.;
+  // Doubling the threads number up to the input one, measuring it too if it
+  // is not a power of 2
+  for (p = 1; p <= n; p = (p < n && 2 * p > n) ? n : 2 * p)
+    {
+#if DEBUG
+      printf ("bench_scaling: threads=%u\n", p);
+#endif
+      nthreads = p;
+      if (weak)
+        {
+          factor = pow (p, 1. / (2 + fractal_3D));
+          sw = lround (w * factor);
+          sh = lround (h * factor);
+          sl = fractal_3D ? lround (l * factor) : l;
+          if (sw > MEDIUM_MAX || sh > MEDIUM_MAX || sl > MEDIUM_MAX)
+            {
+              show_error (_("Medium too big to scale"));
+              break;
+            }
+          width = sw;
+          height = sh;
+          length = sl;
+        }
+      bench_measure (time, steps, points, warmup, repetitions);
+      cache_isolation = !isolation;
+      bench_measure (time_switched, steps_switched, points, warmup,
+                     repetitions);
+      cache_isolation = isolation;
+      bench_statistics (time, repetitions, &time_mean, &time_variance);
+      bench_statistics (steps, repetitions, &steps_mean, &steps_variance);
+      bench_statistics (steps_switched, repetitions, &switched_mean,
+                        &switched_variance);
+      if (p == 1)
+        {
+          time_1 = time_mean;
+          steps_1 = steps_mean;
+        }
+
+      // Time speedup on strong scaling. The walker steps grow faster than the
+      // medium volume, so the weak scaling speedup is the steps/s one
+      if (weak)
+        speedup = steps_mean / steps_1;
+      else
+        speedup = time_1 / time_mean;
+      efficiency = speedup / p;
+      if (p > 1)
+        serial = (1. / speedup - 1. / p) / (1. - 1. / p);
+      else
+        serial = 0.;
+      fprintf (file, "%u\t%u\t%u\t%u\t%.6f\t%g\t%g\t%g\t%g\t%g\t%g\t%g"
+               "\t%g\n", p, width, height, length, time_mean, time_variance,
+               steps_mean, steps_variance, speedup, efficiency, serial,
+               isolation ? switched_mean : steps_mean,
+               isolation ? steps_mean : switched_mean);
+      fflush (file);
+    }
+  nthreads = n;
+  width = w;
+  height = h;
+  length = l;
+  fclose (file);
+  return 1;
+}
+
+/**
+ * Function to get the steps/s of a fractal run.
+ *
+ * \return walker steps/s.
+ */
+static double
+bench_rng_steps (unsigned int n)        ///< Threads number.
+{
+  nthreads = n;
+  fractal ();
+  return walker_steps / fractal_time;
+}
+
+/**
+ * Function to run a microbenchmark of the pseudo-random number generators.
+ * For every generator it measures the raw draws/s, the random point
+ * movements/s and the steps/s of a short fractal run with 1 thread and with
+ * the full threads number, saving a table separated by tabulators.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+bench_rng (char *filename,      ///< Microbenchmark table file name.
+           unsigned int sized)
+///< 1 on using the medium sizes of an input file, 0 on default sizes.
+{
+  double rate[5];
+  gsl_rng *rng;
+  FILE *file;
+  gint64 t;
+  unsigned long i, sum;
+  unsigned int j, n;
+  file = fopen (filename, "w");
+  if (!file)
+    {
+      show_error (_("Unable to open the random benchmark file"));
+      return 0;
+    }
+  fprintf (file, "random-type\tdraws/s\tmoves-2d/s\tmoves-2d-diagonal/s"
+           "\tmoves-3d/s\tmoves-3d-diagonal/s\tthreads\tsteps/s-1"
+           "\tsteps/s-threads\n");
+  animating = 0;
+  random_seed_type = RANDOM_SEED_TYPE_FIXED;
+  if (!sized)
+    {
+      if (fractal_3D)
+        width = height = length = BENCH_SIZE_3D;
+      else
+        width = height = length = BENCH_SIZE_2D;
+    }
+  n = nthreads;
+  for (random_algorithm = 0; random_algorithm < N_RANDOM_TYPES;
+       ++random_algorithm)
+    {
+#if DEBUG
+      printf ("bench_rng: random=%u\n", random_algorithm);
+#endif
+      rng = gsl_rng_alloc (fractal_random_type (random_algorithm));
+      gsl_rng_set (rng, random_seed);
+      t = g_get_monotonic_time ();
+      for (i = 0, sum = 0l; i < BENCH_DRAWS; ++i)
+        sum += gsl_rng_get (rng);
+      bench_sink = sum;
+      rate[0] = BENCH_DRAWS * 1e6 / (g_get_monotonic_time () - t);
+      for (j = 0; j < 4; ++j)
+        {
+          t = g_get_monotonic_time ();
+          sum += fractal_moves (rng, j, BENCH_DRAWS);
+          bench_sink = sum;
+          rate[j + 1] = BENCH_DRAWS * 1e6 / (g_get_monotonic_time () - t);
+        }
+      gsl_rng_free (rng);
+#if DEBUG
+      printf ("bench_rng: sum=%lu\n", sum);
+#endif
+      fprintf (file, "%s\t%g\t%g\t%g\t%g\t%g\t%u\t%g\t%g\n",
+               random_type_name[random_algorithm], rate[0], rate[1], rate[2],
+               rate[3], rate[4], n, bench_rng_steps (1), bench_rng_steps (n));
+      fflush (file);
+    }
+  nthreads = n;
+  fclose (file);
+  return 1;
+}
+
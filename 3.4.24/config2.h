@@ -38,20 +38,78 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define DEBUG 0                 ///< Macro to debug the code.
 
+#define BENCH_DRAWS 10000000
+///< Macro to set the number of draws of the random benchmark.
+#define BENCH_REPETITIONS 3
+///< Macro to set the default number of measured runs of the benchmark.
+#define BENCH_SIZE_2D 256
+///< Macro to set the default 2D medium sizes of the benchmark.
+#define BENCH_SIZE_3D 64
+///< Macro to set the default 3D medium sizes of the benchmark.
+#define BENCH_WARMUP 1
+///< Macro to set the default number of warm-up runs of the benchmark.
+#define CACHE_LINE 128
+///< Macro to set the size to isolate data on different cache lines (bytes).
+#define COUNTERS_BINS 48
+///< Macro to set the number of log2 bins of the walker steps histogram.
+
+#define FRAME_TIME 1000000
+///< Macro to set the time of an animation frame (microseconds).
+#define GRAPHIC_COMPACTION 4
+///< Macro to set the inverse of the fraction of hidden points on the vertex
+///< buffer compacting it.
+#define GRAPHIC_LEVELS 3
+///< Macro to set the number of coarse levels of detail of the 3D points. The
+///< level l aggregates the points on voxels of 2^l sites per side.
+#define GRAPHIC_LOD_POINTS 1048576
+///< Macro to set the maximum number of points drawn on changing the view.
+#define GRAPHIC_LOD_TIME 250
+///< Macro to set the time to draw the full detail after the last view change
+///< (milliseconds).
+#define GRAPHIC_PBOS 2
+///< Macro to set the number of pixel buffers reading back the saved frames
+///< round-robin.
+#define GRAPHIC_POINTS 4096
+///< Macro to set the minimum number of points allocated on the vertex buffer.
 #define HEIGHT 200              ///< Macro to set the default medium height.
 #define LENGTH 320              ///< Macro to set the default medium length.
+#define MEDIUM_MAX 65535
+///< Macro to set the maximum medium sizes, bounded by the 16 bits coordinates
+///< of the points.
+#define METRICS_TIME 1000000
+///< Macro to set the time between live metrics file updates (microseconds).
+#define PERSPECTIVE_PHI -45.
+///< Macro to set the default horizontal perspective angle (in degrees).
+#define PERSPECTIVE_THETA 80.
+///< Macro to set the default vertical perspective angle (in degrees).
+#define REPORT_BUFFER 65536
+///< Macro to set the size of the report file buffer (bytes).
+#define REPORT_DEPTH 8
+///< Macro to set the maximum nesting of the report JSON items.
 #define SEED 7007L
 ///< Macro to set the default pseudo-random number generator seed.
+#define SNAPSHOT_TIME 100000
+///< Macro to set the minimum time between render snapshots (microseconds).
+#define TEXT_ATLAS_COLUMNS 16
+///< Macro to set the number of glyphs per row of the text atlas texture.
+#define TEXT_SIZE 12            ///< Macro to set the text font size (pixels).
+#define WALKER_STEPS 4096
+///< Macro to set the number of walker steps between breaking checks. It bounds
+///< the latency of the stop and frame end requests.
 #define WIDTH 320               ///< Macro to set the default medium width.
 
 #define XML_3D          (const xmlChar *)"iii-d"
 ///< iii-d XML label.
 #define XML_ANIMATE     (const xmlChar *)"animate"
 ///< animate XML label.
+#define XML_CACHE_ISOLATION (const xmlChar *)"cache-isolation"
+///< cache-isolation XML label.
 #define XML_CLOCK       (const xmlChar *)"clock"
 ///< clock XML label.
 #define XML_CMRG        (const xmlChar *)"cmrg"
 ///< cmrg XML label.
+#define XML_CONTINUOUS  (const xmlChar *)"continuous"
+///< continuous XML label.
 #define XML_DEFAULT     (const xmlChar *)"default"
 ///< default XML label.
 #define XML_DIAGONAL    (const xmlChar *)"diagonal"
@@ -37,6 +37,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include <stdatomic.h>
 #include <gsl/gsl_rng.h>
 #include <glib.h>
 #include <png.h>
@@ -58,6 +59,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "graphic.h"
 #include "draw.h"
 #include "simulator.h"
+#include "trace.h"
 
 Graphic graphic[1];             ///< Graphic data.
 
@@ -106,11 +108,13 @@ draw ()
 #if HAVE_GLFW
   int graphic_width, graphic_height;
 #endif
+  gint64 span;
 
 #if DEBUG
   printf ("draw: start\n");
   fflush (stdout);
 #endif
+  span = g_get_monotonic_time ();
 
 #if HAVE_GLFW
   glfwGetFramebufferSize (window, &graphic_width, &graphic_height);
@@ -129,6 +133,7 @@ draw ()
 #elif HAVE_GLFW
   glfwSwapBuffers (window);
 #endif
+  trace_span ("draw", span);
 
 #if DEBUG
   printf ("draw: end\n");
@@ -36,14 +36,20 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <math.h>
 #include <time.h>
+#include <stdatomic.h>
+#if HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
 #if HAVE_SYSINFO
 #include <sys/sysinfo.h>
 #endif
 #include <gsl/gsl_rng.h>
 #include <libxml/parser.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #if HAVE_GTOP
 #include <glibtop.h>
 #include <glibtop/close.h>
@@ -59,17 +65,27 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "config2.h"
 #include "fractal.h"
 #include "simulator.h"
-
-extern void draw ();
+#include "trace.h"
+#include "perf.h"
+#include "report.h"
 
 unsigned int width = WIDTH;     ///< Medium width.
 unsigned int height = HEIGHT;   ///< Medium height.
 unsigned int length = LENGTH;   ///< Medium length.
 unsigned int area;              ///< Medium area.
 unsigned int medium_bytes;      ///< Number of bytes used by the medium.
-unsigned int breaking = 0;      ///< 1 on breaking, 0 otherwise.
+static atomic_uint breaking = 0;
+///< BreakingFlag bits requesting the threads to stop, 0 on running.
+static gint64 breaking_time[N_BREAKING_FLAGS];
+///< Monotonic times of the breaking requests (microseconds).
+unsigned long breaking_latency[N_BREAKING_FLAGS];
+///< Maximum latencies of the breaking requests (microseconds).
+static GCond breaking_cond[1];  ///< GCond to signal a stop request.
 unsigned int simulating = 0;    ///< 1 on simulating, 0 otherwise.
 unsigned int animating = 1;     ///< 1 on animating, 0 otherwise.
+unsigned int batch = 0;         ///< 1 on batch mode, 0 on interface mode.
+unsigned int continuous = 0;
+///< 1 on animating without stopping the threads, 0 otherwise.
 
 unsigned int fractal_type = FRACTAL_TYPE_TREE;  ///< Fractal type.
 unsigned int fractal_3D = 0;    ///< 1 on 3D fractals, 0 on 2D fractals.
@@ -77,38 +93,48 @@ unsigned int fractal_diagonal = 0;
 ///< 1 on diagonal point movement, 0 otherwise.
 
 unsigned long t0;               ///< Computational time.
+double fractal_time = 0.;
+///< Monotonic computational time (seconds).
+static gint64 start_time;
+///< Monotonic start time of the simulation (microseconds).
+static gint64 frame_start;
+///< Monotonic start time of the frame steps (microseconds).
+static unsigned long frame_steps;
+///< Number of walker steps at the start of the frame.
+char *metrics_name = NULL;      ///< Live metrics file name, NULL on none.
+static unsigned long *metrics_steps;
+///< Array of walker steps of every thread on the last live metrics.
+static gint64 metrics_time;
+///< Monotonic time of the last live metrics (microseconds).
+static GThread *thread_fractal = NULL;
+///< GThread running the fractal simulation bucle.
 
-unsigned int max_d = 0;         ///< Maximum fractal size.
 unsigned int *medium = NULL;    ///< Array of fractal points.
-Point3D *point = NULL;          ///< Array of 3D points.
-unsigned int npoints = 0;       ///< Number of points.
-
+unsigned long walker_steps = 0; ///< Number of walker steps.
+unsigned long walker_steps_saved = 0;
+///< Number of walker steps saved resuming walkers across frames.
+static Snapshot snapshot[2];    ///< Double buffer of render snapshots.
+static unsigned int snapshot_front = 0;
+///< Index of the render snapshot to draw.
+static GMutex snapshot_mutex[1];
+///< Mutex to lock the render snapshot swap.
+static unsigned int snapshot_run = 0;
+///< Number of the simulation run of the render snapshots.
+
+const char *fractal_type_name[N_FRACTAL_TYPES] = {
+  "tree", "forest", "neuron"
+};                              ///< Array of fractal type names.
+const char *random_type_name[N_RANDOM_TYPES] = {
+  "mt19937", "ranlxs0", "ranlxs1", "ranlxs2", "ranlxd1", "ranlxd2",
+  "ranlux", "ranlux389", "cmrg", "mrg", "taus2", "gfsr4"
+};                              ///< Array of random algorithm names.
 unsigned int random_algorithm = 0;
 ///< Type of random numbers generator algorithm.
 unsigned int random_seed_type = 1;      ///< Type of random seed.
 unsigned long random_seed = SEED;       ///< Random seed.
-static void *(*parallel_fractal) (gsl_rng * rng);
+static void *(*parallel_fractal) (Walker * walker);
 ///< Pointer to the function to calculate the fractal.
 
-static const float color3f[16][3] = {
-  {0., 0., 0.},
-  {1., 0., 0.},
-  {0., 1., 0.},
-  {0., 0., 1.},
-  {0.5, 0.5, 0.},
-  {0.5, 0., 0.5},
-  {0., 0.5, 0.5},
-  {0.5, 0.25, 0.25},
-  {0.25, 0.5, 0.25},
-  {0.25, 0.25, 0.5},
-  {0.75, 0.25, 0.},
-  {0.75, 0., 0.25},
-  {0.25, 0.75, 0.},
-  {0., 0.75, 0.25},
-  {0.25, 0., 0.75},
-  {0., 0.25, 0.75}
-};                              ///< Array of colors.
-
 DialogOptions dialog_options[1];
   ///< DialogOptions to set the fractal options.
 DialogSimulator dialog_simulator[1];
@@ -117,10 +143,47 @@ DialogSimulator dialog_simulator[1];
 // PARALLELIZING DATA
 
 unsigned int nthreads;          ///< Threads number.
-GMutex mutex[1];                ///< Mutex to lock memory saves.
+unsigned int cache_isolation = 1;
+///< 1 on isolating the thread data on different cache lines, 0 otherwise.
+static Shared shared[1];
+///< Shared data written by the threads, isolated on their own cache lines.
 
 // END
 
+#if HAVE_COUNTERS
+static Counters counters_previous[1];
+///< Hot path counters of the previous frame.
+#endif
+
+#if HAVE_PERF_EVENT
+static unsigned long *perf_count;
+///< Array of hardware performance counters by thread and PerfEvent.
+#endif
+
+#if HAVE_LOCK_PROFILE
+
+static LockProfile *lock_profile = NULL;
+///< Array of lock contention profiles by call site and thread.
+static _Thread_local unsigned int lock_thread = G_MAXUINT;
+///< Thread number of the walker, G_MAXUINT on other threads.
+static _Thread_local unsigned long lock_time[2];
+///< Monotonic times of the lock request and acquisition (nanoseconds).
+static const char *lock_site_name[N_LOCK_SITES] = {
+  "points", "max_d", "stop", "snapshot", "progress"
+};                              ///< Array of lock call site names.
+
+#define MUTEX_LOCK(site) (lock_profile_lock ())
+///< Macro to lock the shared mutex profiling the contention.
+#define MUTEX_UNLOCK(site) (lock_profile_unlock (site))
+///< Macro to unlock the shared mutex profiling the contention.
+
+#else
+
+#define MUTEX_LOCK(site) (g_mutex_lock (shared->mutex))
+#define MUTEX_UNLOCK(site) (g_mutex_unlock (shared->mutex))
+
+#endif
+
 /**
  * Function to return the square of an unsigned int.
 
@@ -158,6 +221,57 @@ threads_number ()
 #endif
 }
 
+#if HAVE_LOCK_PROFILE
+
+/**
+ * Function to get a monotonic time in nanoseconds.
+ *
+ * \return monotonic time (nanoseconds).
+ */
+static inline unsigned long
+lock_profile_time ()
+{
+  struct timespec t;
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000l + t.tv_nsec;
+}
+
+/**
+ * Function to lock the shared mutex saving the request and acquisition times.
+ */
+static inline void
+lock_profile_lock ()
+{
+  lock_time[0] = lock_profile_time ();
+  g_mutex_lock (shared->mutex);
+  lock_time[1] = lock_profile_time ();
+}
+
+/**
+ * Function to unlock the shared mutex adding the wait and hold times to the
+ * profile of the call site and thread. The profile is updated holding the
+ * mutex.
+ */
+static inline void
+lock_profile_unlock (unsigned int site) ///< LockSite.
+{
+  LockProfile *p;
+  unsigned long wait;
+  if (lock_profile)
+    {
+      p = lock_profile + site * (nthreads + 1)
+        + MIN (lock_thread, nthreads);
+      wait = lock_time[1] - lock_time[0];
+      ++p->count;
+      p->wait += wait;
+      p->hold += lock_profile_time () - lock_time[1];
+      p->max_wait = MAX (p->max_wait, wait);
+    }
+  g_mutex_unlock (shared->mutex);
+}
+
+#endif
+
 /**
  * Function to add a point to the array.
  */
@@ -168,13 +282,88 @@ points_add (int x,              ///< Point x-coordinate.
             unsigned int c)     ///< Point color.
 {
   Point3D *p;
-  ++npoints;
-  point = (Point3D *) g_realloc (point, npoints * sizeof (Point3D));
-  p = point + npoints - 1;
+  ++shared->npoints;
+  shared->point = (Point3D *)
+    g_realloc (shared->point, shared->npoints * sizeof (Point3D));
+  p = shared->point + shared->npoints - 1;
   p->r[0] = x;
   p->r[1] = y;
   p->r[2] = z;
-  memcpy (p->c, color3f[c], 3 * sizeof (float));
+  p->c = c;
+  p->hidden = 0;
+}
+
+/**
+ * Function to check if a 3D site is buried, with its 6 neighbours inside the
+ * medium and filled.
+ *
+ * \return 1 on buried, 0 on exposed.
+ */
+static inline unsigned int
+site_3D_buried (unsigned int *point,    ///< Pointer to the medium site.
+                int x,          ///< Site x-coordinate.
+                int y,          ///< Site y-coordinate.
+                int z)          ///< Site z-coordinate.
+{
+  return x > 0 && y > 0 && z > 0 && x < (int) length - 1
+    && y < (int) width - 1 && z < (int) height - 1
+    && point[1] && point[-1] && point[length] && point[-(int) length]
+    && point[area] && point[-(int) area];
+}
+
+/**
+ * Function to hide the point of a buried 3D site.
+ */
+static inline void
+site_3D_hide (unsigned int *point,      ///< Pointer to the medium site.
+              int x,            ///< Site x-coordinate.
+              int y,            ///< Site y-coordinate.
+              int z)            ///< Site z-coordinate.
+{
+  unsigned int i;
+  i = point[0] >> SITE_COLOR_BITS;
+  if (!i-- || shared->point[i].hidden || !site_3D_buried (point, x, y, z))
+    return;
+  shared->point[i].hidden = 1;
+  if (shared->nhidden == shared->nhidden_allocated)
+    {
+      shared->nhidden_allocated = 2 * shared->nhidden + 1;
+      shared->hidden = (unsigned int *)
+        g_realloc (shared->hidden,
+                   shared->nhidden_allocated * sizeof (unsigned int));
+    }
+  shared->hidden[shared->nhidden++] = i;
+}
+
+/**
+ * Function to fill a 3D site adding its point to the array, and to hide the
+ * site and the neighbour sites buried by it. The site keeps the point index
+ * over the color bits. It has to be called locking the points mutex.
+ */
+static inline void
+points_add_3D (unsigned int *point,     ///< Pointer to the medium site.
+               int x,           ///< Point x-coordinate.
+               int y,           ///< Point y-coordinate.
+               int z,           ///< Point z-coordinate.
+               unsigned int c)  ///< Point color.
+{
+  point[0] = c;
+  if (shared->npoints < SITE_INDEX_MAX)
+    point[0] |= (shared->npoints + 1) << SITE_COLOR_BITS;
+  points_add (x, y, z, c);
+  site_3D_hide (point, x, y, z);
+  if (x < (int) length - 1 && point[1])
+    site_3D_hide (point + 1, x + 1, y, z);
+  if (x > 0 && point[-1])
+    site_3D_hide (point - 1, x - 1, y, z);
+  if (y < (int) width - 1 && point[length])
+    site_3D_hide (point + length, x, y + 1, z);
+  if (y > 0 && point[-(int) length])
+    site_3D_hide (point - length, x, y - 1, z);
+  if (z < (int) height - 1 && point[area])
+    site_3D_hide (point + area, x, y, z + 1);
+  if (z > 0 && point[-(int) area])
+    site_3D_hide (point - area, x, y, z - 1);
 }
 
 /**
@@ -262,7 +451,7 @@ tree_2D_point_new (int *x,      ///< Point x-coordinate.
                    gsl_rng *rng)        ///< Pseudo-random number generator.
 {
   *x = gsl_rng_uniform_int (rng, width);
-  *y = max_d;
+  *y = shared->max_d;
 #if DEBUG
   printf ("New point x %d y %d\n", *x, *y);
 #endif
@@ -270,8 +459,10 @@ tree_2D_point_new (int *x,      ///< Point x-coordinate.
 
 /**
  * Function to check the limits of a 2D tree point.
+ *
+ * \return BoundaryType.
  */
-static inline void
+static inline unsigned int
 tree_2D_point_boundary (int *x, ///< Point x-coordinate.
                         int *y, ///< Point y-coordinate.
                         gsl_rng *rng)   ///< Pseudo-random number generator.
@@ -279,15 +470,18 @@ tree_2D_point_boundary (int *x, ///< Point x-coordinate.
   if (*y < 0 || *y == (int) height)
     {
       tree_2D_point_new (x, y, rng);
-      return;
+      return BOUNDARY_RESPAWN;
     }
   if (*x < 0)
     *x = width - 1;
   else if (*x == (int) width)
     *x = 0;
+  else
+    return BOUNDARY_NONE;
 #if DEBUG
   printf ("Boundary point x %d y %d\n", *x, *y);
 #endif
+  return BOUNDARY_WRAP;
 }
 
 /**
@@ -301,10 +495,10 @@ tree_2D_point_fix (int x,       ///< Point x-coordinate.
 {
   register unsigned int *point;
 #if DEBUG
-  printf ("x=%d y=%d max_d=%d width=%d height=%d\n", x, y, max_d, width,
-          height);
+  printf ("x=%d y=%d max_d=%d width=%d height=%d\n", x, y, shared->max_d,
+          width, height);
 #endif
-  if (y > (int) max_d || x == 0 || y == 0 || x == (int) width - 1
+  if (y > (int) shared->max_d || x == 0 || y == 0 || x == (int) width - 1
       || y == (int) height - 1)
     return 0;
   point = medium + y * width + x;
@@ -314,10 +508,10 @@ tree_2D_point_fix (int x,       ///< Point x-coordinate.
       printf ("fixing point\n");
 #endif
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
+      MUTEX_LOCK (LOCK_SITE_POINTS);
       point[0] = 2;
       points_add (x, y, 0, 2);
-      g_mutex_unlock (mutex);
+      MUTEX_UNLOCK (LOCK_SITE_POINTS);
 // END
       return 1;
     }
@@ -341,20 +535,20 @@ tree_2D_init ()
 static inline unsigned int
 tree_2D_end (int y)             ///< Point y-coordinate.
 {
-  if (y == (int) max_d)
+  if (y == (int) shared->max_d)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      ++max_d;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      ++shared->max_d;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
     }
-  if (max_d >= height - 1)
+  if (shared->max_d >= height - 1)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      max_d = height - 1;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      shared->max_d = height - 1;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
       return 1;
     }
@@ -372,7 +566,7 @@ tree_3D_point_new (int *x,      ///< Point x-coordinate.
 {
   *x = gsl_rng_uniform_int (rng, length);
   *y = gsl_rng_uniform_int (rng, width);
-  *z = max_d;
+  *z = shared->max_d;
 #if DEBUG
   printf ("New point x %d y %d z %d\n", *x, *y, *z);
 #endif
@@ -380,18 +574,23 @@ tree_3D_point_new (int *x,      ///< Point x-coordinate.
 
 /**
  * Function to check the limits of a 2D tree point.
+ *
+ * \return BoundaryType.
  */
-static inline void
+static inline unsigned int
 tree_3D_point_boundary (int *x, ///< Point x-coordinate.
                         int *y, ///< Point y-coordinate.
                         int *z, ///< Point z-coordinate.
                         gsl_rng *rng)   ///< Pseudo-random number generator.
 {
+  register unsigned int k;
   if (*z < 0 || *z == (int) height)
     {
       tree_3D_point_new (x, y, z, rng);
-      return;
+      return BOUNDARY_RESPAWN;
     }
+  k = (*x < 0 || *x == (int) length || *y < 0 || *y == (int) width)
+    ? BOUNDARY_WRAP : BOUNDARY_NONE;
   if (*x < 0)
     *x = length - 1;
   else if (*x == (int) length)
@@ -403,6 +602,7 @@ tree_3D_point_boundary (int *x, ///< Point x-coordinate.
 #if DEBUG
   printf ("New point x %d y %d z %d\n", *x, *y, *z);
 #endif
+  return k;
 }
 
 /**
@@ -416,18 +616,18 @@ tree_3D_point_fix (int x,       ///< Point x-coordinate.
                    int z)       ///< point z-coordinate.
 {
   register unsigned int *point;
-  if (z > (int) max_d || z == 0 || y == 0 || x == 0 || z == (int) height - 1
-      || y == (int) width - 1 || x == (int) length - 1)
+  if (z > (int) shared->max_d || z == 0 || y == 0 || x == 0
+      || z == (int) height - 1 || y == (int) width - 1
+      || x == (int) length - 1)
     return 0;
   point = medium + z * area + y * length + x;
   if (point[1] || point[-1] || point[length] || point[-(int) length]
       || point[area] || point[-(int) area])
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      point[0] = 2;
-      points_add (x, y, z, 2);
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_POINTS);
+      points_add_3D (point, x, y, z, 2);
+      MUTEX_UNLOCK (LOCK_SITE_POINTS);
 // END
       return 1;
     }
@@ -451,20 +651,20 @@ tree_3D_init ()
 static inline unsigned int
 tree_3D_end (int z)             ///< Point z-coordinate.
 {
-  if (z == (int) max_d)
+  if (z == (int) shared->max_d)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      ++max_d;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      ++shared->max_d;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
     }
-  if (max_d >= height - 1)
+  if (shared->max_d >= height - 1)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      max_d = height - 1;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      shared->max_d = height - 1;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
       return 1;
     }
@@ -473,8 +673,10 @@ tree_3D_end (int z)             ///< Point z-coordinate.
 
 /**
  * Function to check the limits of a 2D forest point.
+ *
+ * \return BoundaryType.
  */
-static inline void
+static inline unsigned int
 forest_2D_point_boundary (int *x,       ///< Point x-coordinate.
                           int *y,       ///< Point y-coordinate.
                           gsl_rng *rng)
@@ -483,15 +685,18 @@ forest_2D_point_boundary (int *x,       ///< Point x-coordinate.
   if (*y == (int) height || *y < 0)
     {
       tree_2D_point_new (x, y, rng);
-      return;
+      return BOUNDARY_RESPAWN;
     }
   if (*x < 0)
     *x = width - 1;
   else if (*x == (int) width)
     *x = 0;
+  else
+    return BOUNDARY_NONE;
 #if DEBUG
   printf ("Boundary point x %d y %d\n", *x, *y);
 #endif
+  return BOUNDARY_WRAP;
 }
 
 /**
@@ -505,7 +710,7 @@ forest_2D_point_fix (int x,     ///< Point x-coordinate.
                      gsl_rng *rng)      ///< Pseudo-random number generator.
 {
   register unsigned int k, *point;
-  if (y > (int) max_d || x == 0 || x == (int) width - 1
+  if (y > (int) shared->max_d || x == 0 || x == (int) width - 1
       || y == (int) height - 1)
     return 0;
   point = medium + y * width + x;
@@ -530,29 +735,34 @@ forest_2D_point_fix (int x,     ///< Point x-coordinate.
 
 forest:
 // PARALLELIZING MUTEX
-  g_mutex_lock (mutex);
+  MUTEX_LOCK (LOCK_SITE_POINTS);
   point[0] = k;
   points_add (x, y, 0, k);
-  g_mutex_unlock (mutex);
+  MUTEX_UNLOCK (LOCK_SITE_POINTS);
 // END
   return k;
 }
 
 /**
  * Function to check the limits of a 3D forest point.
+ *
+ * \return BoundaryType.
  */
-static inline void
+static inline unsigned int
 forest_3D_point_boundary (int *x,       ///< Point x-coordinate.
                           int *y,       ///< Point y-coordinate.
                           int *z,       ///< Point z-coordinate.
                           gsl_rng *rng)
 ///< Pseudo-random number generator.
 {
+  register unsigned int k;
   if (*z == (int) height || *z < 0)
     {
       tree_3D_point_new (x, y, z, rng);
-      return;
+      return BOUNDARY_RESPAWN;
     }
+  k = (*y < 0 || *y == (int) width || *x < 0 || *x == (int) length)
+    ? BOUNDARY_WRAP : BOUNDARY_NONE;
   if (*y < 0)
     *y = width - 1;
   else if (*y == (int) width)
@@ -564,6 +774,7 @@ forest_3D_point_boundary (int *x,       ///< Point x-coordinate.
 #if DEBUG
   printf ("Boundary point x %d y %d z %d\n", *x, *y, *z);
 #endif
+  return k;
 }
 
 /**
@@ -578,7 +789,7 @@ forest_3D_point_fix (int x,     ///< Point x-coordinate.
                      gsl_rng *rng)      ///< Pseudo-random number generator.
 {
   register unsigned int k, *point;
-  if (z > (int) max_d || y == 0 || x == 0 || z == (int) height - 1
+  if (z > (int) shared->max_d || y == 0 || x == 0 || z == (int) height - 1
       || y == (int) width - 1 || x == (int) length - 1)
     return 0;
   point = medium + z * area + y * length + x;
@@ -587,32 +798,31 @@ forest_3D_point_fix (int x,     ///< Point x-coordinate.
       k = 1 + gsl_rng_uniform_int (rng, 15);
       goto forest;
     }
-  k = point[1];
+  k = point[1] & SITE_COLOR_MASK;
   if (k)
     goto forest;
-  k = point[-1];
+  k = point[-1] & SITE_COLOR_MASK;
   if (k)
     goto forest;
-  k = point[length];
+  k = point[length] & SITE_COLOR_MASK;
   if (k)
     goto forest;
-  k = point[-(int) length];
+  k = point[-(int) length] & SITE_COLOR_MASK;
   if (k)
     goto forest;
-  k = point[area];
+  k = point[area] & SITE_COLOR_MASK;
   if (k)
     goto forest;
-  k = point[-(int) area];
+  k = point[-(int) area] & SITE_COLOR_MASK;
   if (k)
     goto forest;
   return 0;
 
 forest:
 // PARALLELIZING MUTEX
-  g_mutex_lock (mutex);
-  point[0] = k;
-  points_add (x, y, z, k);
-  g_mutex_unlock (mutex);
+  MUTEX_LOCK (LOCK_SITE_POINTS);
+  points_add_3D (point, x, y, z, k);
+  MUTEX_UNLOCK (LOCK_SITE_POINTS);
 // END
   return k;
 }
@@ -627,8 +837,8 @@ neuron_2D_point_new (int *x,    ///< Point x-coordinate.
 {
   register double angle;
   angle = 2 * M_PI * gsl_rng_uniform (rng);
-  *x = width / 2 + max_d * cos (angle);
-  *y = height / 2 + max_d * sin (angle);
+  *x = width / 2 + shared->max_d * cos (angle);
+  *y = height / 2 + shared->max_d * sin (angle);
 #if DEBUG
   printf ("New point x %d y %d\n", *x, *y);
 #endif
@@ -636,8 +846,10 @@ neuron_2D_point_new (int *x,    ///< Point x-coordinate.
 
 /**
  * Function to check the limits of a 2D neuron point.
+ *
+ * \return BoundaryType.
  */
-static inline void
+static inline unsigned int
 neuron_2D_point_boundary (int *x,       ///< Point x-coordinate.
                           int *y,       ///< Point y-coordinate.
                           gsl_rng *rng)
@@ -649,7 +861,9 @@ neuron_2D_point_boundary (int *x,       ///< Point x-coordinate.
 #if DEBUG
       printf ("Boundary point x %d y %d\n", *x, *y);
 #endif
+      return BOUNDARY_RESPAWN;
     }
+  return BOUNDARY_NONE;
 }
 
 /**
@@ -668,10 +882,10 @@ neuron_2D_point_fix (int x,     ///< Point x-coordinate.
   if (point[1] || point[-1] || point[width] || point[-(int) width])
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
+      MUTEX_LOCK (LOCK_SITE_POINTS);
       point[0] = 2;
       points_add (x, y, 0, 2);
-      g_mutex_unlock (mutex);
+      MUTEX_UNLOCK (LOCK_SITE_POINTS);
 // END
       return 1;
     }
@@ -698,12 +912,12 @@ neuron_2D_end (int x,           ///< Point x-coordinate.
 {
   register int r, k;
   r = 1 + round (sqrt (sqr (x - width / 2) + sqr (y - height / 2)));
-  if (r >= (int) max_d)
+  if (r >= (int) shared->max_d)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      ++max_d;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      ++shared->max_d;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
     }
   if (height < width)
@@ -711,12 +925,12 @@ neuron_2D_end (int x,           ///< Point x-coordinate.
   else
     k = width;
   k = k / 2 - 1;
-  if ((int) max_d >= k)
+  if ((int) shared->max_d >= k)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      max_d = k;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      shared->max_d = k;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
       return 1;
     }
@@ -735,9 +949,9 @@ neuron_3D_point_new (int *x,    ///< Point x-coordinate.
   double c1, s1, c2, s2;
   sincos (2. * M_PI * gsl_rng_uniform (rng), &s1, &c1);
   sincos (asin (2. * gsl_rng_uniform (rng) - 1), &s2, &c2);
-  *x = length / 2 + max_d * c1 * c2;
-  *y = width / 2 + max_d * s1 * c2;
-  *z = height / 2 + max_d * s2;
+  *x = length / 2 + shared->max_d * c1 * c2;
+  *y = width / 2 + shared->max_d * s1 * c2;
+  *z = height / 2 + shared->max_d * s2;
 #if DEBUG
   printf ("New point x %d y %d z %d\n", *x, *y, *z);
 #endif
@@ -745,8 +959,10 @@ neuron_3D_point_new (int *x,    ///< Point x-coordinate.
 
 /**
  * Function to check the limits of a 3D neuron point.
+ *
+ * \return BoundaryType.
  */
-static inline void
+static inline unsigned int
 neuron_3D_point_boundary (int *x,       ///< Point x-coordinate.
                           int *y,       ///< Point y-coordinate.
                           int *z,       ///< Point z-coordinate.
@@ -760,7 +976,9 @@ neuron_3D_point_boundary (int *x,       ///< Point x-coordinate.
 #if DEBUG
       printf ("Boundary point x %d y %d z %d\n", *x, *y, *z);
 #endif
+      return BOUNDARY_RESPAWN;
     }
+  return BOUNDARY_NONE;
 }
 
 /**
@@ -782,10 +1000,9 @@ neuron_3D_point_fix (int x,     ///< Point x-coordinate.
       point[area] || point[-(int) area])
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      point[0] = 2;
-      points_add (x, y, z, 2);
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_POINTS);
+      points_add_3D (point, x, y, z, 2);
+      MUTEX_UNLOCK (LOCK_SITE_POINTS);
 // END
       return 1;
     }
@@ -814,12 +1031,12 @@ neuron_3D_end (int x,           ///< Point x-coordinate.
   register int r, k;
   r = 1 + sqrt (sqr (x - length / 2) + sqr (y - width / 2)
                 + sqr (z - height / 2));
-  if (r >= (int) max_d)
+  if (r >= (int) shared->max_d)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      ++max_d;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      ++shared->max_d;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
     }
   k = length;
@@ -828,12 +1045,12 @@ neuron_3D_end (int x,           ///< Point x-coordinate.
   if ((int) height < k)
     k = height;
   k = k / 2 - 1;
-  if ((int) max_d >= k)
+  if ((int) shared->max_d >= k)
     {
 // PARALLELIZING MUTEX
-      g_mutex_lock (mutex);
-      max_d = k;
-      g_mutex_unlock (mutex);
+      MUTEX_LOCK (LOCK_SITE_MAX_D);
+      shared->max_d = k;
+      MUTEX_UNLOCK (LOCK_SITE_MAX_D);
 // END
       return 1;
     }
@@ -841,18 +1058,147 @@ neuron_3D_end (int x,           ///< Point x-coordinate.
 }
 
 /**
- * Function to stop the fractal simulation.
+ * Function to publish a render snapshot of the fractal.
+ *
+ * The points added since the last update of the back snapshot are copied on
+ * it and then it is swapped with the front snapshot unless the front one is
+ * being drawn, so the threads never wait for the drawing.
  */
 void
-fractal_stop ()
+snapshot_publish ()
+{
+  Snapshot *s;
+  unsigned int n;
+  s = snapshot + (1 - snapshot_front);
+// PARALLELIZING MUTEX
+  MUTEX_LOCK (LOCK_SITE_SNAPSHOT);
+  n = shared->npoints;
+  if (n > s->nallocated)
+    {
+      s->nallocated = 2 * n;
+      s->point
+        = (Point3D *) g_realloc (s->point, s->nallocated * sizeof (Point3D));
+    }
+  memcpy (s->point + s->npoints, shared->point + s->npoints,
+          (n - s->npoints) * sizeof (Point3D));
+  s->npoints = n;
+  for (; s->nhidden < shared->nhidden; ++s->nhidden)
+    s->point[shared->hidden[s->nhidden]].hidden = 1;
+  s->max_d = shared->max_d;
+  MUTEX_UNLOCK (LOCK_SITE_SNAPSHOT);
+// END
+  if (g_mutex_trylock (snapshot_mutex))
+    {
+      snapshot_front = 1 - snapshot_front;
+      g_mutex_unlock (snapshot_mutex);
+    }
+}
+
+/**
+ * Function to get the last published render snapshot locking it until
+ * calling snapshot_release().
+ *
+ * \return pointer to the front render snapshot.
+ */
+Snapshot *
+snapshot_acquire ()
+{
+  g_mutex_lock (snapshot_mutex);
+  return snapshot + snapshot_front;
+}
+
+/**
+ * Function to release the render snapshot got with snapshot_acquire().
+ */
+void
+snapshot_release ()
+{
+  g_mutex_unlock (snapshot_mutex);
+}
+
+/**
+ * Function to add the steps of a finished walk. Only the walker thread writes
+ * its steps, so a relaxed load and store are enough to be read by the live
+ * metrics while walking.
+ */
+static inline void
+walker_steps_add (Walker *walker,       ///< Walker struct.
+                  unsigned long nsteps) ///< Number of steps of the walk.
+{
+  atomic_store_explicit (&walker->steps,
+                         atomic_load_explicit (&walker->steps,
+                                               memory_order_relaxed) + nsteps,
+                         memory_order_relaxed);
+}
+
+/**
+ * Function to check if the threads have to break. A relaxed load is enough
+ * because the mutex or the thread joins synchronize the data after a break.
+ *
+ * \return BreakingFlag bits, 0 on running.
+ */
+static inline unsigned int
+fractal_breaking ()
+{
+  return atomic_load_explicit (&breaking, memory_order_relaxed);
+}
+
+/**
+ * Function to request the threads to break.
+ */
+static void
+fractal_break (unsigned int flag)       ///< BreakingFlag.
+{
+// PARALLELIZING MUTEX
+  MUTEX_LOCK (LOCK_SITE_STOP);
+  if (!(atomic_load (&breaking) & flag))
+    {
+      breaking_time[flag >> 1] = g_get_monotonic_time ();
+      atomic_fetch_or (&breaking, flag);
+    }
+  g_cond_signal (breaking_cond);
+  MUTEX_UNLOCK (LOCK_SITE_STOP);
+// END
+}
+
+/**
+ * Function to wait a stop request or a time limit.
+ */
+static void
+fractal_wait (gint64 end_time)  ///< Monotonic time limit (microseconds).
 {
 // PARALLELIZING MUTEX
-  g_mutex_lock (mutex);
-  breaking = 1;
-  g_mutex_unlock (mutex);
+  g_mutex_lock (shared->mutex);
+  while (!(atomic_load (&breaking) & BREAKING_STOP)
+         && g_cond_wait_until (breaking_cond, shared->mutex, end_time));
+  g_mutex_unlock (shared->mutex);
 // END
 }
 
+/**
+ * Function to update the maximum latency of a breaking request once the
+ * threads are joined.
+ */
+static void
+fractal_latency (unsigned int flag)     ///< BreakingFlag.
+{
+  unsigned long latency;
+  if (!(atomic_load (&breaking) & flag))
+    return;
+  latency = g_get_monotonic_time () - breaking_time[flag >> 1];
+  if (latency > breaking_latency[flag >> 1])
+    breaking_latency[flag >> 1] = latency;
+}
+
+/**
+ * Function to stop the fractal simulation.
+ */
+void
+fractal_stop ()
+{
+  fractal_break (BREAKING_STOP);
+}
+
 // PARALLELIZED FUNCTIONS
 
 /**
@@ -861,25 +1207,35 @@ fractal_stop ()
  * \return NULL.
  */
 void *
-parallel_fractal_tree_2D (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_tree_2D (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y;
-  long t0;
 #if DEBUG
   printf ("parallel_fractal_tree_2D: start\n");
 #endif
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  nsteps = walker->nsteps;
   do
     {
+      if (!walker->walking)
+        {
 #if DEBUG
-      printf ("creating point\n");
+          printf ("creating point\n");
 #endif
-      tree_2D_point_new (&x, &y, rng);
+          tree_2D_point_new (&x, &y, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
 #if DEBUG
       printf ("checking fix\n");
 #endif
-      while (!breaking && !tree_2D_point_fix (x, y))
+      while (!COUNTERS_TRY (walker, tree_2D_point_fix (x, y)))
         {
 #if DEBUG
           printf ("moving point\n");
@@ -888,18 +1244,28 @@ parallel_fractal_tree_2D (gsl_rng *rng)
 #if DEBUG
           printf ("checking boundary\n");
 #endif
-          tree_2D_point_boundary (&x, &y, rng);
+          COUNTERS_BOUNDARY (walker, tree_2D_point_boundary (&x, &y, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
 #if DEBUG
       printf ("checking end\n");
 #endif
-      if (animating && time (NULL) > t0)
-        break;
       if (tree_2D_end (y))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -909,27 +1275,49 @@ parallel_fractal_tree_2D (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_tree_3D (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_tree_3D (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y, z;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  z = walker->z;
+  nsteps = walker->nsteps;
   do
     {
-      tree_3D_point_new (&x, &y, &z, rng);
-      while (!breaking && !tree_3D_point_fix (x, y, z))
+      if (!walker->walking)
+        {
+          tree_3D_point_new (&x, &y, &z, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, tree_3D_point_fix (x, y, z)))
         {
           point_3D_move (&x, &y, &z, rng);
-          tree_3D_point_boundary (&x, &y, &z, rng);
+          COUNTERS_BOUNDARY (walker, tree_3D_point_boundary (&x, &y, &z, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_3D_end (z))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->z = z;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -939,27 +1327,47 @@ parallel_fractal_tree_3D (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_forest_2D (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_forest_2D (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  nsteps = walker->nsteps;
   do
     {
-      tree_2D_point_new (&x, &y, rng);
-      while (!breaking && !forest_2D_point_fix (x, y, rng))
+      if (!walker->walking)
+        {
+          tree_2D_point_new (&x, &y, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, forest_2D_point_fix (x, y, rng)))
         {
           point_2D_move (&x, &y, rng);
-          forest_2D_point_boundary (&x, &y, rng);
+          COUNTERS_BOUNDARY (walker, forest_2D_point_boundary (&x, &y, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_2D_end (y))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -969,27 +1377,50 @@ parallel_fractal_forest_2D (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_forest_3D (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_forest_3D (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y, z;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  z = walker->z;
+  nsteps = walker->nsteps;
   do
     {
-      tree_3D_point_new (&x, &y, &z, rng);
-      while (!breaking && !forest_3D_point_fix (x, y, z, rng))
+      if (!walker->walking)
+        {
+          tree_3D_point_new (&x, &y, &z, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, forest_3D_point_fix (x, y, z, rng)))
         {
           point_3D_move (&x, &y, &z, rng);
-          forest_3D_point_boundary (&x, &y, &z, rng);
+          COUNTERS_BOUNDARY (walker,
+                             forest_3D_point_boundary (&x, &y, &z, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_3D_end (z))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->z = z;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -999,27 +1430,47 @@ parallel_fractal_forest_3D (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_neuron_2D (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_neuron_2D (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  nsteps = walker->nsteps;
   do
     {
-      neuron_2D_point_new (&x, &y, rng);
-      while (!breaking && !neuron_2D_point_fix (x, y))
+      if (!walker->walking)
+        {
+          neuron_2D_point_new (&x, &y, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, neuron_2D_point_fix (x, y)))
         {
           point_2D_move (&x, &y, rng);
-          neuron_2D_point_boundary (&x, &y, rng);
+          COUNTERS_BOUNDARY (walker, neuron_2D_point_boundary (&x, &y, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (neuron_2D_end (x, y))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1029,27 +1480,50 @@ parallel_fractal_neuron_2D (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_neuron_3D (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_neuron_3D (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y, z;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  z = walker->z;
+  nsteps = walker->nsteps;
   do
     {
-      neuron_3D_point_new (&x, &y, &z, rng);
-      while (!breaking && !neuron_3D_point_fix (x, y, z))
+      if (!walker->walking)
+        {
+          neuron_3D_point_new (&x, &y, &z, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, neuron_3D_point_fix (x, y, z)))
         {
           point_3D_move (&x, &y, &z, rng);
-          neuron_3D_point_boundary (&x, &y, &z, rng);
+          COUNTERS_BOUNDARY (walker,
+                             neuron_3D_point_boundary (&x, &y, &z, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (neuron_3D_end (x, y, z))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->z = z;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1059,27 +1533,47 @@ parallel_fractal_neuron_3D (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_tree_2D_diagonal (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_tree_2D_diagonal (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  nsteps = walker->nsteps;
   do
     {
-      tree_2D_point_new (&x, &y, rng);
-      while (!breaking && !tree_2D_point_fix (x, y))
+      if (!walker->walking)
+        {
+          tree_2D_point_new (&x, &y, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, tree_2D_point_fix (x, y)))
         {
           point_2D_move (&x, &y, rng);
-          tree_2D_point_boundary (&x, &y, rng);
+          COUNTERS_BOUNDARY (walker, tree_2D_point_boundary (&x, &y, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_2D_end (y))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1089,27 +1583,49 @@ parallel_fractal_tree_2D_diagonal (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_tree_3D_diagonal (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_tree_3D_diagonal (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y, z;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  z = walker->z;
+  nsteps = walker->nsteps;
   do
     {
-      tree_3D_point_new (&x, &y, &z, rng);
-      while (!breaking && !tree_3D_point_fix (x, y, z))
+      if (!walker->walking)
+        {
+          tree_3D_point_new (&x, &y, &z, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, tree_3D_point_fix (x, y, z)))
         {
           point_3D_move (&x, &y, &z, rng);
-          tree_3D_point_boundary (&x, &y, &z, rng);
+          COUNTERS_BOUNDARY (walker, tree_3D_point_boundary (&x, &y, &z, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_3D_end (z))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->z = z;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1119,27 +1635,47 @@ parallel_fractal_tree_3D_diagonal (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_forest_2D_diagonal (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_forest_2D_diagonal (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  nsteps = walker->nsteps;
   do
     {
-      tree_2D_point_new (&x, &y, rng);
-      while (!breaking && !forest_2D_point_fix (x, y, rng))
+      if (!walker->walking)
+        {
+          tree_2D_point_new (&x, &y, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, forest_2D_point_fix (x, y, rng)))
         {
           point_2D_move_diagonal (&x, &y, rng);
-          forest_2D_point_boundary (&x, &y, rng);
+          COUNTERS_BOUNDARY (walker, forest_2D_point_boundary (&x, &y, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_2D_end (y))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1149,27 +1685,50 @@ parallel_fractal_forest_2D_diagonal (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_forest_3D_diagonal (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_forest_3D_diagonal (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y, z;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  z = walker->z;
+  nsteps = walker->nsteps;
   do
     {
-      tree_3D_point_new (&x, &y, &z, rng);
-      while (!breaking && !forest_3D_point_fix (x, y, z, rng))
+      if (!walker->walking)
+        {
+          tree_3D_point_new (&x, &y, &z, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, forest_3D_point_fix (x, y, z, rng)))
         {
           point_3D_move_diagonal (&x, &y, &z, rng);
-          forest_3D_point_boundary (&x, &y, &z, rng);
+          COUNTERS_BOUNDARY (walker,
+                             forest_3D_point_boundary (&x, &y, &z, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (tree_3D_end (z))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->z = z;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1179,27 +1738,47 @@ parallel_fractal_forest_3D_diagonal (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_neuron_2D_diagonal (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_neuron_2D_diagonal (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  nsteps = walker->nsteps;
   do
     {
-      neuron_2D_point_new (&x, &y, rng);
-      while (!breaking && !neuron_2D_point_fix (x, y))
+      if (!walker->walking)
+        {
+          neuron_2D_point_new (&x, &y, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, neuron_2D_point_fix (x, y)))
         {
           point_2D_move_diagonal (&x, &y, rng);
-          neuron_2D_point_boundary (&x, &y, rng);
+          COUNTERS_BOUNDARY (walker, neuron_2D_point_boundary (&x, &y, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (neuron_2D_end (x, y))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1209,27 +1788,50 @@ parallel_fractal_neuron_2D_diagonal (gsl_rng *rng)
  * \return NULL.
  */
 void *
-parallel_fractal_neuron_3D_diagonal (gsl_rng *rng)
-///< Pseudo-random number generator.
+parallel_fractal_neuron_3D_diagonal (Walker *walker)
+///< Random walker.
 {
+  gsl_rng *rng;
+  unsigned long nsteps;
   int x, y, z;
-  long t0;
-  t0 = time (NULL);
+  rng = walker->rng;
+  x = walker->x;
+  y = walker->y;
+  z = walker->z;
+  nsteps = walker->nsteps;
   do
     {
-      neuron_3D_point_new (&x, &y, &z, rng);
-      while (!breaking && !neuron_3D_point_fix (x, y, z))
+      if (!walker->walking)
+        {
+          neuron_3D_point_new (&x, &y, &z, rng);
+          nsteps = 0;
+          walker->walking = 1;
+          COUNTERS_WALK (walker);
+        }
+      while (!COUNTERS_TRY (walker, neuron_3D_point_fix (x, y, z)))
         {
           point_3D_move_diagonal (&x, &y, &z, rng);
-          neuron_3D_point_boundary (&x, &y, &z, rng);
+          COUNTERS_BOUNDARY (walker,
+                             neuron_3D_point_boundary (&x, &y, &z, rng));
+          ++nsteps;
+          if (!(nsteps % WALKER_STEPS) && fractal_breaking ())
+            goto save_walker;
         }
-      if (animating && time (NULL) > t0)
-        break;
+      walker->walking = 0;
+      walker_steps_add (walker, nsteps);
+      COUNTERS_FIX (walker, nsteps);
       if (neuron_3D_end (x, y, z))
         fractal_stop ();
     }
-  while (!breaking);
-  g_thread_exit (NULL);
+  while (!fractal_breaking ());
+  return NULL;
+
+save_walker:
+  // Saving the walker state to resume it on the next frame
+  walker->x = x;
+  walker->y = y;
+  walker->z = z;
+  walker->nsteps = nsteps;
   return NULL;
 }
 
@@ -1246,13 +1848,24 @@ medium_start ()
 #if DEBUG
   printf ("Deleting points\n");
 #endif
-  g_free (point);
-  point = NULL;
-  npoints = 0;
-
-  j = area = width * length;
+  g_free (shared->point);
+  shared->point = NULL;
+  shared->npoints = 0;
+  g_free (shared->hidden);
+  shared->hidden = NULL;
+  shared->nhidden = shared->nhidden_allocated = 0;
+  g_mutex_lock (snapshot_mutex);
+  snapshot[0].npoints = snapshot[1].npoints = 0;
+  snapshot[0].nhidden = snapshot[1].nhidden = 0;
+  snapshot[0].max_d = snapshot[1].max_d = 0;
+  snapshot[0].run = snapshot[1].run = ++snapshot_run;
+  g_mutex_unlock (snapshot_mutex);
+
+  area = width * length;
   if (fractal_3D)
-    j *= length;
+    j = area * height;
+  else
+    j = width * height;
   medium_bytes = j * sizeof (unsigned int);
   medium = (unsigned int *) g_slice_alloc (medium_bytes);
   for (i = j; --i >= 0;)
@@ -1273,16 +1886,16 @@ medium_start ()
             case FRACTAL_TYPE_TREE:
               tree_3D_init ();
               parallel_fractal = parallel_fractal_tree_3D_diagonal;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             case FRACTAL_TYPE_FOREST:
               parallel_fractal = parallel_fractal_forest_3D_diagonal;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             default:
               neuron_3D_init ();
               parallel_fractal = parallel_fractal_neuron_3D_diagonal;
-              max_d = 2;
+              shared->max_d = 2;
             }
         }
       else
@@ -1292,16 +1905,16 @@ medium_start ()
             case FRACTAL_TYPE_TREE:
               tree_2D_init ();
               parallel_fractal = parallel_fractal_tree_2D_diagonal;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             case FRACTAL_TYPE_FOREST:
               parallel_fractal = parallel_fractal_forest_2D_diagonal;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             default:
               neuron_2D_init ();
               parallel_fractal = parallel_fractal_neuron_2D_diagonal;
-              max_d = 2;
+              shared->max_d = 2;
             }
         }
     }
@@ -1314,16 +1927,16 @@ medium_start ()
             case FRACTAL_TYPE_TREE:
               tree_3D_init ();
               parallel_fractal = parallel_fractal_tree_3D;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             case FRACTAL_TYPE_FOREST:
               parallel_fractal = parallel_fractal_forest_3D;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             default:
               neuron_3D_init ();
               parallel_fractal = parallel_fractal_neuron_3D;
-              max_d = 2;
+              shared->max_d = 2;
             }
         }
       else
@@ -1333,16 +1946,16 @@ medium_start ()
             case FRACTAL_TYPE_TREE:
               tree_2D_init ();
               parallel_fractal = parallel_fractal_tree_2D;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             case FRACTAL_TYPE_FOREST:
               parallel_fractal = parallel_fractal_forest_2D;
-              max_d = 1;
+              shared->max_d = 1;
               break;
             default:
               neuron_2D_init ();
               parallel_fractal = parallel_fractal_neuron_2D;
-              max_d = 2;
+              shared->max_d = 2;
             }
         }
     }
@@ -1429,21 +2042,21 @@ fractal_input (char *filename)  ///< File name.
       goto exit_on_error;
     }
   width = xml_node_get_uint_with_default (node, XML_WIDTH, WIDTH, &error_code);
-  if (error_code)
+  if (error_code || width > MEDIUM_MAX)
     {
       error_message = _("Bad width");
       goto exit_on_error;
     }
   height
     = xml_node_get_uint_with_default (node, XML_HEIGHT, HEIGHT, &error_code);
-  if (error_code)
+  if (error_code || height > MEDIUM_MAX)
     {
       error_message = _("Bad height");
       goto exit_on_error;
     }
   length
     = xml_node_get_uint_with_default (node, XML_LENGTH, LENGTH, &error_code);
-  if (error_code)
+  if (error_code || length > MEDIUM_MAX)
     {
       error_message = _("Bad length");
       goto exit_on_error;
@@ -1496,6 +2109,28 @@ fractal_input (char *filename)  ///< File name.
       goto exit_on_error;
     }
   xmlFree (buffer);
+  buffer = xmlGetProp (node, XML_CONTINUOUS);
+  if (!buffer || !xmlStrcmp (buffer, XML_NO))
+    continuous = 0;
+  else if (!xmlStrcmp (buffer, XML_YES))
+    continuous = 1;
+  else
+    {
+      error_message = _("Bad continuous animation");
+      goto exit_on_error;
+    }
+  xmlFree (buffer);
+  buffer = xmlGetProp (node, XML_CACHE_ISOLATION);
+  if (!buffer || !xmlStrcmp (buffer, XML_YES))
+    cache_isolation = 1;
+  else if (!xmlStrcmp (buffer, XML_NO))
+    cache_isolation = 0;
+  else
+    {
+      error_message = _("Bad cache isolation");
+      goto exit_on_error;
+    }
+  xmlFree (buffer);
   buffer = xmlGetProp (node, XML_TYPE);
   if (!buffer || !xmlStrcmp (buffer, XML_TREE))
     fractal_type = FRACTAL_TYPE_TREE;
@@ -1564,15 +2199,114 @@ exit_on_error:
 }
 
 /**
- * Function with the main bucle to draw the fractal.
+ * Function to get the number of fixed points of the fractal.
+ *
+ * \return number of fixed points.
  */
-void
-fractal ()
+unsigned int
+fractal_points ()
 {
-  const gsl_rng_type *random_type[N_RANDOM_TYPES] = {
-    gsl_rng_mt19937,
-    gsl_rng_ranlxs0,
-    gsl_rng_ranlxs1,
+  return shared->npoints;
+}
+
+/**
+ * Function to save the fractal results and timings on a file.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+fractal_results (char *filename)        ///< File name.
+{
+  FILE *file;
+  file = fopen (filename, "w");
+  if (!file)
+    {
+      show_error (_("Unable to open the results file"));
+      return 0;
+    }
+  fprintf (file, "type %s\n", fractal_type_name[fractal_type]);
+  fprintf (file, "iii-d %u\n", fractal_3D);
+  fprintf (file, "diagonal %u\n", fractal_diagonal);
+  fprintf (file, "width %u\n", width);
+  fprintf (file, "height %u\n", height);
+  fprintf (file, "length %u\n", length);
+  fprintf (file, "threads %u\n", nthreads);
+  fprintf (file, "random-type %s\n",
+           random_type_name[random_algorithm]);
+  fprintf (file, "random-seed %lu\n", random_seed);
+  fprintf (file, "points %u\n", shared->npoints);
+  fprintf (file, "max-d %u\n", shared->max_d);
+  fprintf (file, "steps %lu\n", walker_steps);
+  fprintf (file, "time %.6f\n", fractal_time);
+  fprintf (file, "steps/s %g\n", walker_steps / fractal_time);
+  fprintf (file, "points/s %g\n", shared->npoints / fractal_time);
+  fprintf (file, "stop-latency %lu\n", breaking_latency[0]);
+  fprintf (file, "frame-latency %lu\n", breaking_latency[1]);
+  fclose (file);
+  return 1;
+}
+
+/**
+ * Function to get the progress fraction of a fractal.
+ *
+ * \return progress fraction.
+ */
+float
+fractal_progress (unsigned int d)       ///< Maximum fractal size.
+{
+  register unsigned int k;
+  register float x;
+  if (fractal_3D)
+    {
+      switch (fractal_type)
+        {
+        case 0:
+        case 1:
+          x = d / (float) (height - 1);
+          break;
+        default:
+          k = length;
+          if (width < k)
+            k = width;
+          if (height < k)
+            k = height;
+          k = k / 2;
+          if (k)
+            --k;
+          x = fmin (1., d / (float) k);
+        }
+    }
+  else
+    {
+      switch (fractal_type)
+        {
+        case 0:
+        case 1:
+          x = d / (float) (height - 1);
+          break;
+        default:
+          k = width;
+          if (height < k)
+            k = height;
+          k = k / 2 - 1;
+          x = fmin (1., d / (float) k);
+        }
+    }
+  return x;
+}
+
+/**
+ * Function to get a pseudo-random number generator type.
+ *
+ * \return pseudo-random number generator type.
+ */
+const gsl_rng_type *
+fractal_random_type (unsigned int algorithm)    ///< Random algorithm type.
+{
+  const gsl_rng_type *random_type[N_RANDOM_TYPES] = {
+    gsl_rng_mt19937,
+    gsl_rng_ranlxs0,
+    gsl_rng_ranlxs1,
     gsl_rng_ranlxs2,
     gsl_rng_ranlxd1,
     gsl_rng_ranlxd2,
@@ -1583,12 +2317,524 @@ fractal ()
     gsl_rng_taus2,
     gsl_rng_gfsr4
   };
+  return random_type[algorithm];
+}
+
+/**
+ * Function to do random point movements to benchmark them.
+ *
+ * \return sum of the final coordinates.
+ */
+long
+fractal_moves (gsl_rng *rng,    ///< Pseudo-random number generator.
+               unsigned int type,
+               ///< Movement type: 0 on 2D, 1 on 2D diagonal, 2 on 3D, 3 on 3D
+               ///< diagonal.
+               unsigned long n) ///< Number of movements.
+{
+  int x, y, z;
+  x = y = z = 0;
+  switch (type)
+    {
+    case 0:
+      while (n--)
+        point_2D_move (&x, &y, rng);
+      break;
+    case 1:
+      while (n--)
+        point_2D_move_diagonal (&x, &y, rng);
+      break;
+    case 2:
+      while (n--)
+        point_3D_move (&x, &y, &z, rng);
+      break;
+    default:
+      while (n--)
+        point_3D_move_diagonal (&x, &y, &z, rng);
+    }
+  return x + y + z;
+}
+
+/**
+ * Function to open the random walkers of the threads. On cache isolation the
+ * walkers and the states of their pseudo-random number generators are
+ * allocated on different cache lines for every thread.
+ *
+ * \return pointer to the memory block to free.
+ */
+static void *
+walkers_open (Walker **walker,  ///< Array of random walker pointers.
+              const gsl_rng_type *type, ///< Pseudo-random generator type.
+              unsigned int isolated)    ///< 1 on cache isolation.
+{
+  char *memory, *block;
+  size_t stride;
+  unsigned int i;
+  if (isolated)
+    {
+      stride = (sizeof (Walker) + type->size + CACHE_LINE - 1)
+        / CACHE_LINE * CACHE_LINE;
+      memory = (char *) g_malloc (nthreads * stride + CACHE_LINE);
+      block = (char *) (((uintptr_t) memory + CACHE_LINE - 1)
+                        & ~(uintptr_t) (CACHE_LINE - 1));
+    }
+  else
+    {
+      stride = sizeof (Walker);
+      memory = block = (char *) g_malloc (nthreads * stride);
+    }
+  for (i = 0; i < nthreads; ++i, block += stride)
+    {
+      walker[i] = (Walker *) block;
+      if (isolated)
+        {
+          walker[i]->rng = walker[i]->generator;
+          walker[i]->rng->type = type;
+          walker[i]->rng->state = block + sizeof (Walker);
+          gsl_rng_set (walker[i]->rng, gsl_rng_default_seed);
+        }
+      else
+        walker[i]->rng = gsl_rng_alloc (type);
+      switch (random_seed_type)
+        {
+        case RANDOM_SEED_TYPE_DEFAULT:
+          break;
+        case RANDOM_SEED_TYPE_CLOCK:
+          gsl_rng_set (walker[i]->rng, (unsigned long) clock () + i);
+          break;
+        default:
+          gsl_rng_set (walker[i]->rng, random_seed + i);
+        }
+      walker[i]->nsteps = walker[i]->steps = 0l;
+      walker[i]->walking = 0;
+      walker[i]->id = i;
+#if HAVE_COUNTERS
+      memset (walker[i]->counters, 0, sizeof (Counters));
+#endif
+    }
+  return memory;
+}
+
+/**
+ * Function to count the walker steps of a set of walkers, including the steps
+ * of the current walks.
+ *
+ * \return number of walker steps.
+ */
+static unsigned long
+walkers_steps (Walker **walker, ///< Array of random walker pointers.
+               unsigned int n)  ///< Number of walkers.
+{
+  unsigned long steps;
+  unsigned int i;
+  for (i = 0, steps = 0l; i < n; ++i)
+    {
+      steps += walker[i]->steps;
+      if (walker[i]->walking)
+        steps += walker[i]->nsteps;
+    }
+  return steps;
+}
+
+/**
+ * Function to get the maximum fractal size and the number of points. The
+ * shared data are locked, so they can be read while the threads are walking.
+ */
+static void
+fractal_size (unsigned int *max_d,      ///< Maximum fractal size.
+              unsigned int *npoints)    ///< Number of points.
+{
+// PARALLELIZING MUTEX
+  MUTEX_LOCK (LOCK_SITE_PROGRESS);
+  *max_d = shared->max_d;
+  *npoints = shared->npoints;
+  MUTEX_UNLOCK (LOCK_SITE_PROGRESS);
+// END
+}
+
+/**
+ * Function to post the fractal progress to the simulator dialog.
+ */
+static void
+fractal_post (unsigned int end) ///< 1 on the simulation end, 0 otherwise.
+{
+  Progress *progress;
+  if (batch)
+    return;
+#if DEBUG
+  printf ("Posting progress to the simulator dialog\n");
+#endif
+  progress = (Progress *) g_slice_alloc (sizeof (Progress));
+  progress->time = difftime (time (NULL), t0);
+  fractal_size (&progress->max_d, &progress->npoints);
+  progress->fraction = fractal_progress (progress->max_d);
+  progress->end = end;
+  dialog_simulator_post (progress);
+}
+
+#if HAVE_COUNTERS
+
+/**
+ * Function to add the hot path counters of all the threads.
+ */
+static void
+counters_add (Counters *total,  ///< Total counters.
+              Walker **walker)  ///< Array of random walker pointers.
+{
+  Counters *c;
+  unsigned int i, j;
+  memset (total, 0, sizeof (Counters));
+  for (i = 0; i < nthreads; ++i)
+    {
+      c = walker[i]->counters;
+      for (j = 0; j < N_BOUNDARY_TYPES; ++j)
+        total->boundary[j] += c->boundary[j];
+      total->walks += c->walks;
+      total->attempts += c->attempts;
+      for (j = 0; j < COUNTERS_BINS; ++j)
+        total->histogram[j] += c->histogram[j];
+    }
+}
+
+/**
+ * Function to save the hot path counters, or their increments from previous
+ * counters, on the report.
+ */
+static void
+counters_report (Counters *c,   ///< Counters.
+                 Counters *previous)    ///< Previous counters or NULL.
+{
+  unsigned long n[6];
+  unsigned int j;
+  n[0] = c->boundary[BOUNDARY_NONE] + c->boundary[BOUNDARY_WRAP]
+    + c->boundary[BOUNDARY_RESPAWN];
+  n[1] = c->boundary[BOUNDARY_WRAP];
+  n[2] = c->boundary[BOUNDARY_RESPAWN];
+  n[3] = c->walks;
+  n[4] = c->attempts;
+  for (j = 0, n[5] = 0l; j < COUNTERS_BINS; ++j)
+    n[5] += c->histogram[j];
+  if (previous)
+    {
+      n[0] -= previous->boundary[BOUNDARY_NONE]
+        + previous->boundary[BOUNDARY_WRAP]
+        + previous->boundary[BOUNDARY_RESPAWN];
+      n[1] -= previous->boundary[BOUNDARY_WRAP];
+      n[2] -= previous->boundary[BOUNDARY_RESPAWN];
+      n[3] -= previous->walks;
+      n[4] -= previous->attempts;
+      for (j = 0; j < COUNTERS_BINS; ++j)
+        n[5] -= previous->histogram[j];
+    }
+  report_uint ("steps", n[0]);
+  report_uint ("wraps", n[1]);
+  report_uint ("respawns", n[2]);
+  report_uint ("walks", n[3]);
+  report_uint ("attempts", n[4]);
+  report_uint ("fixes", n[5]);
+}
+
+/**
+ * Function to save the hot path counters increments of a frame on the
+ * report.
+ */
+static void
+counters_frame (Walker **walker)        ///< Array of random walker pointers.
+{
+  Counters total[1];
+  counters_add (total, walker);
+  report_object ("counters");
+  counters_report (total, counters_previous);
+  report_end ();
+  memcpy (counters_previous, total, sizeof (Counters));
+}
+
+/**
+ * Function to save the hot path counters at the end of the run on the report:
+ * the totals, the counters of every thread and the histogram of fixed walkers
+ * by steps.
+ */
+static void
+counters_end (Walker **walker)  ///< Array of random walker pointers.
+{
+  Counters total[1];
+  unsigned int i, n;
+  counters_add (total, walker);
+  report_object ("counters");
+  counters_report (total, NULL);
+  report_array ("threads");
+  for (i = 0; i < nthreads; ++i)
+    {
+      report_object (NULL);
+      counters_report (walker[i]->counters, NULL);
+      report_end ();
+    }
+  report_end ();
+  for (i = n = 0; i < COUNTERS_BINS; ++i)
+    if (total->histogram[i])
+      n = i + 1;
+  report_array ("histogram");
+  for (i = 0; i < n; ++i)
+    report_uint (NULL, total->histogram[i]);
+  report_end ();
+  report_end ();
+}
+
+#endif
+
+/**
+ * Function to save the live metrics file. It is written on a temporal file
+ * renamed over the metrics file, so readers never get a partial file. The
+ * walker steps rates are got from the steps of the finished walks since the
+ * last live metrics, so they can be read while the threads are walking.
+ */
+static void
+fractal_metrics (Walker **walker,       ///< Array of random walker pointers.
+                 gint64 t,      ///< Monotonic time (microseconds).
+                 unsigned int end)
+///< 1 on the simulation end, 0 otherwise.
+{
   FILE *file;
+  char *name;
+  double time, dt, fraction;
+  unsigned long steps[nthreads];
+  unsigned long total, previous;
+  unsigned int i, max_d, npoints;
+#if DEBUG
+  printf ("Saving live metrics\n");
+#endif
+  name = g_strconcat (metrics_name, ".tmp", NULL);
+  file = fopen (name, "w");
+  if (!file)
+    {
+      g_free (name);
+      return;
+    }
+  time = 1e-6 * (t - start_time);
+  dt = 1e-6 * (t - metrics_time);
+  for (i = 0, total = previous = 0l; i < nthreads; ++i)
+    {
+      steps[i] = atomic_load_explicit (&walker[i]->steps,
+                                       memory_order_relaxed);
+      total += steps[i];
+      previous += metrics_steps[i];
+    }
+  fractal_size (&max_d, &npoints);
+  fraction = fractal_progress (max_d);
+  fprintf (file, "{\"time\": %.6f, \"fraction\": %g, \"npoints\": %u, "
+           "\"max_d\": %u, \"eta\": ", time, fraction, npoints, max_d);
+  if (end)
+    fprintf (file, "0");
+  else if (fraction > 0.)
+    fprintf (file, "%.3f", time * (1. - fraction) / fraction);
+  else
+    fprintf (file, "null");
+  if (dt <= 0.)
+    dt = 1e-6;
+  fprintf (file, ", \"steps\": %lu, \"steps/s\": %g, \"threads\": [",
+           total, (total - previous) / dt);
+  for (i = 0; i < nthreads; ++i)
+    {
+      fprintf (file, "%s%g", i ? ", " : "",
+               (steps[i] - metrics_steps[i]) / dt);
+      metrics_steps[i] = steps[i];
+    }
+  fprintf (file, "], \"end\": %u}\n", end);
+  fclose (file);
+  g_rename (name, metrics_name);
+  g_free (name);
+  metrics_time = t;
+}
+
+/**
+ * Function to wait a stop request or a time limit, saving the live metrics
+ * file every METRICS_TIME while the threads are walking.
+ */
+static void
+fractal_watch (Walker **walker, ///< Array of random walker pointers.
+               gint64 end_time) ///< Monotonic time limit (microseconds).
+{
+  gint64 t;
+  if (metrics_name)
+    while (!(atomic_load (&breaking) & BREAKING_STOP))
+      {
+        t = metrics_time + METRICS_TIME;
+        if (t >= end_time)
+          break;
+        fractal_wait (t);
+        if (!(atomic_load (&breaking) & BREAKING_STOP))
+          fractal_metrics (walker, g_get_monotonic_time (), 0);
+      }
+  fractal_wait (end_time);
+}
+
+/**
+ * Function to publish, show and report a fractal frame. The walker steps and
+ * the hot path counters are only reported on frames with joined threads.
+ */
+static void
+fractal_frame (Walker **walker, ///< Array of random walker pointers.
+               unsigned long nsaved,    ///< Number of walker steps saved.
+               unsigned int joined)
+///< 1 on joined threads, 0 on running threads.
+{
+  gint64 t;
+  unsigned long steps;
+  unsigned int max_d, npoints;
+#if DEBUG
+  printf ("Publishing render snapshot\n");
+#endif
+  if (!batch)
+    snapshot_publish ();
+
+// DISPLAYING DRAW
+  fractal_post (0);
+// END
+
+#if DEBUG
+  printf ("Saving report frame\n");
+#endif
+  t = g_get_monotonic_time ();
+  report_object (NULL);
+  report_double ("time", 1e-6 * (t - start_time));
+  fractal_size (&max_d, &npoints);
+  report_uint ("max_d", max_d);
+  report_uint ("npoints", npoints);
+  if (joined)
+    {
+      steps = walkers_steps (walker, nthreads);
+      report_uint ("steps", steps);
+      report_uint ("steps-saved", nsaved);
+      report_double ("steps/s",
+                     (steps - frame_steps) * 1e6 / (t - frame_start));
+#if HAVE_COUNTERS
+      counters_frame (walker);
+#endif
+    }
+  report_end ();
+  if (joined)
+    {
+      frame_steps = steps;
+      frame_start = t;
+    }
+}
+
+#if HAVE_LOCK_PROFILE
+
+/**
+ * Function to save the fields of a lock contention profile on the report.
+ */
+static void
+lock_profile_fields (LockProfile *p)    ///< LockProfile.
+{
+  report_uint ("count", p->count);
+  report_uint ("wait-ns", p->wait);
+  report_uint ("hold-ns", p->hold);
+  report_uint ("max-wait-ns", p->max_wait);
+}
+
+/**
+ * Function to save the lock contention profiles on the report: the totals and
+ * the profile of every thread by call site. The "other" thread is the main
+ * bucle and the interface.
+ */
+static void
+lock_profile_report ()
+{
+  LockProfile *p, total[1];
+  unsigned int i, j;
+  report_object ("locks");
+  for (i = 0; i < N_LOCK_SITES; ++i)
+    {
+      memset (total, 0, sizeof (LockProfile));
+      for (j = 0, p = lock_profile + i * (nthreads + 1); j <= nthreads;
+           ++j, ++p)
+        {
+          total->count += p->count;
+          total->wait += p->wait;
+          total->hold += p->hold;
+          total->max_wait = MAX (total->max_wait, p->max_wait);
+        }
+      report_object (lock_site_name[i]);
+      lock_profile_fields (total);
+      report_array ("threads");
+      for (j = 0, p = lock_profile + i * (nthreads + 1); j <= nthreads;
+           ++j, ++p)
+        if (p->count)
+          {
+            report_object (NULL);
+            if (j < nthreads)
+              report_uint ("thread", j);
+            else
+              report_string ("thread", "other");
+            lock_profile_fields (p);
+            report_end ();
+          }
+      report_end ();
+      report_end ();
+    }
+  report_end ();
+}
+
+#endif
+
+/**
+ * Function to run the parallelized fractal function of a walker thread saving
+ * the thread number to profile the locks and trace the timeline.
+ *
+ * \return NULL.
+ */
+static void *
+walker_thread (void *data)      ///< Random walker.
+{
+  Walker *walker = (Walker *) data;
+  gint64 start;
+#if HAVE_PERF_EVENT
+  int fd[N_PERF_EVENTS];
+#endif
+  start = g_get_monotonic_time ();
+#if HAVE_LOCK_PROFILE
+  lock_thread = walker->id;
+#endif
+  trace_thread (TRACE_THREAD_WALKER + walker->id);
+#if HAVE_PERF_EVENT
+  if (perf)
+    perf_open (fd);
+#endif
+  parallel_fractal (walker);
+#if HAVE_PERF_EVENT
+  if (perf)
+    perf_close (fd, perf_count + walker->id * N_PERF_EVENTS);
+#endif
+  trace_span ("walk", start);
+  return NULL;
+}
+
+/**
+ * Function with the main bucle to draw the fractal.
+ */
+void
+fractal ()
+{
+  const char *random_seed_name[N_RANDOM_SEED_TYPES] = {
+    "default", "clock", "fixed"
+  };
+#if HAVE_GETRUSAGE
+  struct rusage usage;
+#endif
+  gint64 frame_time, span;
+  unsigned long nsaved;
   unsigned int i;
 
 // PARALLELIZING DATA
-  gsl_rng *rng[nthreads];
+  Walker *walker[nthreads];
   GThread *thread[nthreads];
+  void *walkers;
+  char name[32];
+  unsigned int isolated;
+#if HAVE_PERF_EVENT
+  unsigned int j;
+#endif
 
   t0 = time (NULL);
 #if DEBUG
@@ -1596,37 +2842,63 @@ fractal ()
 #endif
 
 #if DEBUG
-  printf ("Opening log file\n");
+  printf ("Opening report file\n");
+#endif
+  if (!report_open (report_name) && batch)
+    show_error (_("Unable to open the report file"));
+  report_object ("configuration");
+  report_string ("type", fractal_type_name[fractal_type]);
+  report_uint ("iii-d", fractal_3D);
+  report_uint ("diagonal", fractal_diagonal);
+  report_uint ("width", width);
+  report_uint ("height", height);
+  report_uint ("length", length);
+  report_uint ("threads", nthreads);
+  report_uint ("cache-isolation", cache_isolation);
+  report_uint ("animate", animating);
+  report_uint ("continuous", continuous);
+  report_string ("random-type", random_type_name[random_algorithm]);
+  report_string ("random-seed-type", random_seed_name[random_seed_type]);
+  report_uint ("random-seed", random_seed);
+  report_end ();
+  report_host (threads_number ());
+  report_array ("frames");
+#if HAVE_COUNTERS
+  memset (counters_previous, 0, sizeof (Counters));
 #endif
-  file = fopen ("log", "w");
 
 #if DEBUG
   printf ("Opening pseudo-random generators\n");
 #endif
+  isolated = cache_isolation;
+  walkers = walkers_open (walker, fractal_random_type (random_algorithm),
+                          isolated);
   for (i = 0; i < nthreads; ++i)
     {
-      rng[i] = gsl_rng_alloc (random_type[random_algorithm]);
-      switch (random_seed_type)
-        {
-        case RANDOM_SEED_TYPE_DEFAULT:
-          break;
-        case RANDOM_SEED_TYPE_CLOCK:
-          gsl_rng_set (rng[i], (unsigned long) clock () + i);
-          break;
-        default:
-          gsl_rng_set (rng[i], random_seed + i);
-        }
+      snprintf (name, 32, "walker %u", i);
+      trace_name (TRACE_THREAD_WALKER + i, name);
     }
+  walker_steps_saved = 0;
 
-// END
+#if HAVE_PERF_EVENT
+  if (perf)
+    perf_count = g_new0 (unsigned long, nthreads * N_PERF_EVENTS);
+#endif
 
-  breaking = 0;
-  simulating = 1;
+  if (metrics_name)
+    metrics_steps = g_new0 (unsigned long, nthreads);
 
-#if DEBUG
-  printf ("Updating simulator dialog\n");
+#if HAVE_LOCK_PROFILE
+  g_mutex_lock (shared->mutex);
+  lock_profile = g_new0 (LockProfile, N_LOCK_SITES * (nthreads + 1));
+  g_mutex_unlock (shared->mutex);
 #endif
-  dialog_simulator_update ();
+
+// END
+
+  atomic_store (&breaking, 0);
+  breaking_latency[0] = breaking_latency[1] = 0l;
+  simulating = 1;
 
 #if DEBUG
   printf ("Starting medium\n");
@@ -1636,52 +2908,204 @@ fractal ()
 #if DEBUG
   printf ("Main bucle\n");
 #endif
+  start_time = frame_start = metrics_time = g_get_monotonic_time ();
+  frame_steps = 0l;
   do
     {
 #if DEBUG
       printf ("Calculating fractal\n");
 #endif
+      frame_time = g_get_monotonic_time ();
 // PARALLELIZING CALLS
+      span = g_get_monotonic_time ();
       for (i = 0; i < nthreads; ++i)
-        thread[i] = g_thread_new (NULL, (void (*)) parallel_fractal, rng[i]);
+        thread[i] = g_thread_new (NULL, walker_thread, walker[i]);
+      trace_span ("g_thread_new", span);
+// END
+
+      if (animating)
+        {
+          // Drawing snapshots while the threads are running on continuous
+          // animations
+          if (continuous)
+            while (!(atomic_load (&breaking) & BREAKING_STOP))
+              {
+                frame_time += SNAPSHOT_TIME;
+                span = g_get_monotonic_time ();
+                fractal_watch (walker, frame_time);
+                trace_span ("frame wait", span);
+                span = g_get_monotonic_time ();
+                fractal_frame (walker, 0l, 0);
+                trace_span ("frame", span);
+              }
+
+          // Ending the frame on time or on a stop request
+          else
+            {
+              span = g_get_monotonic_time ();
+              fractal_watch (walker, frame_time + FRAME_TIME);
+              fractal_break (BREAKING_FRAME);
+              trace_span ("frame wait", span);
+            }
+        }
+
+      // Saving the live metrics while the threads are running without
+      // animation
+      else if (metrics_name)
+        fractal_watch (walker, G_MAXINT64);
+
+// PARALLELIZING CALLS
+      span = g_get_monotonic_time ();
       for (i = 0; i < nthreads; ++i)
         g_thread_join (thread[i]);
+      trace_span ("g_thread_join", span);
 // END
+      fractal_latency (BREAKING_STOP);
+      fractal_latency (BREAKING_FRAME);
+      atomic_fetch_and (&breaking, ~BREAKING_FRAME);
 
 #if DEBUG
-      printf ("Updating simulator dialog\n");
+      printf ("Counting the walker steps saved\n");
 #endif
-      dialog_simulator_progress ();
+      for (i = 0, nsaved = 0; i < nthreads; ++i)
+        if (walker[i]->walking)
+          nsaved += walker[i]->nsteps;
+      walker_steps_saved += nsaved;
+
+      span = g_get_monotonic_time ();
+      fractal_frame (walker, nsaved, 1);
+      trace_span ("frame", span);
+    }
+  while (!atomic_load (&breaking));
 
-// DISPLAYING DRAW
 #if DEBUG
-      printf ("Redisplaying draw\n");
+  printf ("Counting the walker steps\n");
 #endif
-      draw ();
-// END
+  fractal_time = 1e-6 * (g_get_monotonic_time () - start_time);
+  walker_steps = walkers_steps (walker, nthreads);
 
 #if DEBUG
-      printf ("Saving log data\n");
+  printf ("Saving the report summary\n");
 #endif
-      fprintf (file, "%d %d\n", max_d, npoints);
-    }
-  while (!breaking);
-
+  report_end ();
+  report_object ("summary");
+  report_double ("time", fractal_time);
+  report_uint ("steps", walker_steps);
+  report_uint ("steps-saved", walker_steps_saved);
+  report_double ("steps/s", walker_steps / fractal_time);
+  report_uint ("npoints", shared->npoints);
+  report_uint ("max_d", shared->max_d);
+  report_uint ("medium-bytes", medium_bytes);
+#if HAVE_GETRUSAGE
+  getrusage (RUSAGE_SELF, &usage);
+  report_uint ("peak-rss-kb", usage.ru_maxrss);
+#endif
+  report_uint ("stop-latency-us", breaking_latency[0]);
+  report_uint ("frame-latency-us", breaking_latency[1]);
+  report_end ();
+#if HAVE_COUNTERS
+  counters_end (walker);
+#endif
+#if HAVE_PERF_EVENT
+  if (perf)
+    {
 #if DEBUG
-  printf ("Closing log file\n");
+      printf ("Saving the hardware performance counters\n");
+#endif
+      memset (perf_total, 0, N_PERF_EVENTS * sizeof (unsigned long));
+      for (i = 0; i < nthreads; ++i)
+        for (j = 0; j < N_PERF_EVENTS; ++j)
+          perf_total[j] += perf_count[i * N_PERF_EVENTS + j];
+      report_object ("perf");
+      perf_report (walker_steps, perf_total);
+      report_array ("threads");
+      for (i = 0; i < nthreads; ++i)
+        {
+          report_object (NULL);
+          perf_report (walkers_steps (walker + i, 1),
+                       perf_count + i * N_PERF_EVENTS);
+          report_end ();
+        }
+      report_end ();
+      report_end ();
+      g_free (perf_count);
+    }
+#endif
+#if HAVE_LOCK_PROFILE
+  g_mutex_lock (shared->mutex);
+  lock_profile_report ();
+  g_free (lock_profile);
+  lock_profile = NULL;
+  g_mutex_unlock (shared->mutex);
 #endif
-  fclose (file);
 
 #if DEBUG
-  printf ("Updating simulator dialog\n");
+  printf ("Closing report file\n");
 #endif
-  breaking = simulating = 0;
-  dialog_simulator_update ();
+  report_close ();
+
+  if (metrics_name)
+    {
+      fractal_metrics (walker, g_get_monotonic_time (), 1);
+      g_free (metrics_steps);
+    }
 
 #if DEBUG
   printf ("Freeing threads\n");
 #endif
-  for (i = 0; i < nthreads; ++i)
-    gsl_rng_free (rng[i]);
+  if (!isolated)
+    for (i = 0; i < nthreads; ++i)
+      gsl_rng_free (walker[i]->rng);
+  g_free (walkers);
   g_slice_free1 (medium_bytes, medium);
+
+#if DEBUG
+  printf ("Posting the end to the simulator dialog\n");
+#endif
+  atomic_store (&breaking, 0);
+  simulating = 0;
+  fractal_post (1);
+}
+
+/**
+ * Function to run the fractal main bucle on a thread.
+ *
+ * \return NULL.
+ */
+static void *
+fractal_thread (void *data __attribute__((unused)))
+///< Unused data.
+{
+  trace_thread (TRACE_THREAD_FRACTAL);
+  fractal ();
+  return NULL;
+}
+
+/**
+ * Function to start the fractal simulation on a thread, keeping the main
+ * loop free to attend the interface.
+ */
+void
+fractal_start ()
+{
+  if (thread_fractal)
+    return;
+#if DEBUG
+  printf ("Updating simulator dialog\n");
+#endif
+  simulating = 1;
+  dialog_simulator_update ();
+  thread_fractal = g_thread_new ("fractal", fractal_thread, NULL);
+}
+
+/**
+ * Function to wait the end of the fractal simulation thread.
+ */
+void
+fractal_join ()
+{
+  if (!thread_fractal)
+    return;
+  g_thread_join (thread_fractal);
+  thread_fractal = NULL;
 }
@@ -53,10 +53,175 @@ typedef struct
  */
 typedef struct
 {
-  float r[3];                   ///< position vector.
-  float c[3];                   ///< color vector.
+  unsigned short r[3];          ///< lattice position vector.
+  unsigned char c;              ///< palette color index.
+  unsigned char hidden;         ///< 1 on buried by its neighbours, 0 on exposed.
 } Point3D;
 
+#define SITE_COLOR_BITS 4
+///< Macro to set the bits of the color on a 3D medium site. The higher bits
+///< keep the index plus one of the site point, 0 on none.
+#define SITE_COLOR_MASK ((1u << SITE_COLOR_BITS) - 1)
+///< Macro to get the color of a 3D medium site.
+#define SITE_INDEX_MAX (G_MAXUINT >> SITE_COLOR_BITS)
+///< Macro to set the maximum number of points indexed by the 3D medium sites.
+
+///> An enum to define the boundary types of a walker step.
+enum BoundaryType
+{
+  BOUNDARY_NONE = 0,            ///< Inside the medium.
+  BOUNDARY_WRAP = 1,            ///< Wrapped by a periodic boundary.
+  BOUNDARY_RESPAWN = 2          ///< Respawned as a new walker.
+};
+
+#define N_BOUNDARY_TYPES (BOUNDARY_RESPAWN + 1)
+  ///< Macro to define the number of boundary types.
+
+#if HAVE_COUNTERS
+
+/**
+ * \struct Counters
+ * \brief A struct to define the hot path counters of a thread.
+ */
+typedef struct
+{
+  unsigned long boundary[N_BOUNDARY_TYPES];
+  ///< Number of walker steps by BoundaryType.
+  unsigned long walks;          ///< Number of new walkers.
+  unsigned long attempts;       ///< Number of fix attempts.
+  unsigned long histogram[COUNTERS_BINS];
+  ///< Histogram of fixed walkers by steps (bin k counts less than 2^k steps).
+} Counters;
+
+#define COUNTERS_WALK(w) (++(w)->counters->walks)
+///< Macro to count a new walker.
+#define COUNTERS_TRY(w, fix) (++(w)->counters->attempts, (fix))
+///< Macro to count a fix attempt.
+#define COUNTERS_BOUNDARY(w, type) (++(w)->counters->boundary[type])
+///< Macro to count a walker step by its BoundaryType.
+#define COUNTERS_FIX(w, n) \
+  (++(w)->counters->histogram[MIN (g_bit_storage (n), COUNTERS_BINS - 1)])
+///< Macro to count a fixed walker by its steps.
+
+#else
+
+#define COUNTERS_WALK(w)
+#define COUNTERS_TRY(w, fix) (fix)
+#define COUNTERS_BOUNDARY(w, type) (type)
+#define COUNTERS_FIX(w, n)
+
+#endif
+
+///> An enum to define the call sites locking the shared mutex.
+enum LockSite
+{
+  LOCK_SITE_POINTS = 0,         ///< Adding a fixed point.
+  LOCK_SITE_MAX_D = 1,          ///< Updating the maximum fractal size.
+  LOCK_SITE_STOP = 2,           ///< Requesting the threads to break.
+  LOCK_SITE_SNAPSHOT = 3,       ///< Publishing a render snapshot.
+  LOCK_SITE_PROGRESS = 4        ///< Reading the fractal progress.
+};
+
+#define N_LOCK_SITES (LOCK_SITE_PROGRESS + 1)
+  ///< Macro to define the number of lock call sites.
+
+#if HAVE_LOCK_PROFILE
+
+/**
+ * \struct LockProfile
+ * \brief A struct to define the contention profile of a lock call site.
+ */
+typedef struct
+{
+  unsigned long count;          ///< Number of acquisitions.
+  unsigned long wait;           ///< Time waiting to acquire (nanoseconds).
+  unsigned long hold;           ///< Time holding the lock (nanoseconds).
+  unsigned long max_wait;       ///< Maximum time waiting (nanoseconds).
+} LockProfile;
+
+#endif
+
+/**
+ * \struct Walker
+ * \brief A struct to define the random walker data of a thread. On cache
+ *   isolation the walkers are allocated on different cache lines followed by
+ *   the state of their pseudo-random number generators.
+ */
+typedef struct
+{
+  gsl_rng *rng;                 ///< Pseudo-random number generator.
+  gsl_rng generator[1];
+  ///< Pseudo-random number generator allocated on cache isolation.
+  unsigned long nsteps;         ///< Number of steps of the current walk.
+  atomic_ulong steps;
+  ///< Number of steps of the finished walks, read while walking by the live
+  ///< metrics.
+  int x;                        ///< x-coordinate.
+  int y;                        ///< y-coordinate.
+  int z;                        ///< z-coordinate.
+  unsigned int walking;         ///< 1 on walking, 0 on a new walker.
+  unsigned int id;              ///< Thread number.
+#if HAVE_COUNTERS
+  Counters counters[1];         ///< Hot path counters.
+#endif
+} Walker;
+
+/**
+ * \struct Snapshot
+ * \brief A struct to define a render snapshot of the fractal.
+ */
+typedef struct
+{
+  Point3D *point;               ///< Array of 3D points.
+  unsigned int npoints;         ///< Number of points.
+  unsigned int nallocated;      ///< Number of allocated points.
+  unsigned int nhidden;         ///< Number of hidden points applied.
+  unsigned int max_d;           ///< Maximum fractal size.
+  unsigned int run;             ///< Number of the simulation run.
+} Snapshot;
+
+/**
+ * \struct Shared
+ * \brief A struct to define the data written by all the threads. The data
+ *   read on every walker step and the data written on every fixed point are
+ *   isolated on different cache lines.
+ */
+typedef struct
+{
+  unsigned int max_d __attribute__((aligned (CACHE_LINE)));
+  ///< Maximum fractal size.
+  GMutex mutex[1] __attribute__((aligned (CACHE_LINE)));
+  ///< Mutex to lock memory saves.
+  Point3D *point;               ///< Array of 3D points.
+  unsigned int *hidden;         ///< Array of the indices of the hidden points.
+  unsigned int npoints;         ///< Number of points.
+  unsigned int nhidden;         ///< Number of hidden points.
+  unsigned int nhidden_allocated;       ///< Number of allocated hidden points.
+} __attribute__((aligned (CACHE_LINE))) Shared;
+
+/**
+ * \struct Progress
+ * \brief A struct to define a progress message of the fractal simulation.
+ */
+typedef struct
+{
+  double time;                  ///< Computational time.
+  float fraction;               ///< Progress fraction.
+  unsigned int max_d;           ///< Maximum fractal size.
+  unsigned int npoints;         ///< Number of points.
+  unsigned int end;             ///< 1 on the simulation end, 0 otherwise.
+} Progress;
+
+///> An enum to define the flags requesting the threads to break.
+enum BreakingFlag
+{
+  BREAKING_STOP = 1,            ///< Stopping the simulation.
+  BREAKING_FRAME = 2            ///< Ending an animation frame.
+};
+
+#define N_BREAKING_FLAGS 2
+  ///< Macro to define the number of breaking flags.
+
 ///> An enum to define fractal types.
 enum FractalType
 {
@@ -112,27 +277,39 @@ enum RandomSeedType
   ///< Macro to define the number of random seed types.
 
 // PARALLELIZING DATA
-extern unsigned int nthreads;
-extern GMutex mutex[1];
+extern unsigned int nthreads, cache_isolation;
 // END
 
 extern unsigned int fractal_type, fractal_3D, fractal_diagonal;
-extern unsigned int width, height, length, area, breaking, simulating,
-  animating;
+extern unsigned int width, height, length, area, simulating, animating,
+  continuous, batch;
 extern unsigned long t0;
 
-extern unsigned int max_d;
 extern unsigned int *medium;
-extern Point3D *point;
-extern unsigned int npoints;
+extern unsigned long walker_steps, walker_steps_saved;
+extern double fractal_time;
+extern unsigned long breaking_latency[N_BREAKING_FLAGS];
+extern char *metrics_name;
 
+extern const char *fractal_type_name[N_FRACTAL_TYPES];
+extern const char *random_type_name[N_RANDOM_TYPES];
 extern unsigned int random_algorithm, random_seed_type;
 extern unsigned long random_seed;
 
 int threads_number ();
+void snapshot_publish ();
+Snapshot *snapshot_acquire ();
+void snapshot_release ();
 void fractal_stop ();
 void medium_start ();
 int fractal_input (char *filename);
+const gsl_rng_type *fractal_random_type (unsigned int algorithm);
+long fractal_moves (gsl_rng * rng, unsigned int type, unsigned long n);
+unsigned int fractal_points ();
+int fractal_results (char *filename);
+float fractal_progress (unsigned int d);
 void fractal ();
+void fractal_start ();
+void fractal_join ();
 
 #endif
@@ -37,6 +37,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdatomic.h>
+#include <libintl.h>
 #include <gsl/gsl_rng.h>
 #include <glib.h>
 #include <png.h>
@@ -49,10 +51,306 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "image.h"
 #include "text.h"
 #include "graphic.h"
+#include "simulator.h"
+#include "trace.h"
 
 unsigned int window_width = 480;        ///< Graphic window width.
 unsigned int window_height = 480;       ///< Graphic window height.
 
+/**
+ * Function to bind the vertex attributes of the 3D program to a buffer of
+ * points.
+ */
+static void
+graphic_attributes (Graphic *graphic,   ///< Graphic struct.
+                    GLuint vbo) ///< Vertex buffer of points.
+{
+  glBindBuffer (GL_ARRAY_BUFFER, vbo);
+  glEnableVertexAttribArray (graphic->attribute_3D_position);
+  glVertexAttribPointer (graphic->attribute_3D_position,
+                         3, GL_UNSIGNED_SHORT, GL_FALSE, sizeof (Point3D),
+                         NULL);
+  glEnableVertexAttribArray (graphic->attribute_3D_color);
+  glVertexAttribPointer (graphic->attribute_3D_color,
+                         1,
+                         GL_UNSIGNED_BYTE,
+                         GL_FALSE,
+                         sizeof (Point3D), (GLvoid *) offsetof (Point3D, c));
+}
+
+/**
+ * Function to draw a buffer of points with the 3D program.
+ */
+static void
+graphic_draw_points (Graphic *graphic,  ///< Graphic struct.
+                     GLuint vao,        ///< Vertex array (0 if unavailable).
+                     GLuint vbo,        ///< Vertex buffer of points.
+                     GLenum mode,       ///< Drawing primitive.
+                     unsigned int n)    ///< Number of points.
+{
+  if (vao)
+    {
+      glBindVertexArray (vao);
+      glDrawArrays (mode, 0, n);
+      glBindVertexArray (0);
+      return;
+    }
+  graphic_attributes (graphic, vbo);
+  glDrawArrays (mode, 0, n);
+  glDisableVertexAttribArray (graphic->attribute_3D_color);
+  glDisableVertexAttribArray (graphic->attribute_3D_position);
+}
+
+/**
+ * Function to copy the exposed points of a render snapshot not yet uploaded
+ * to the exposed points array.
+ *
+ * \return number of exposed points.
+ */
+static unsigned int
+graphic_exposed (Graphic *graphic,      ///< Graphic struct.
+                 Snapshot *s)   ///< Render snapshot.
+{
+  Point3D *p, *end;
+  unsigned int n;
+  n = s->npoints - graphic->vbo_next;
+  if (n > graphic->nexposed)
+    {
+      graphic->nexposed = n;
+      graphic->exposed
+        = (Point3D *) g_realloc (graphic->exposed, n * sizeof (Point3D));
+    }
+  for (n = 0, p = s->point + graphic->vbo_next, end = s->point + s->npoints;
+       p < end; ++p)
+    if (!p->hidden)
+      graphic->exposed[n++] = *p;
+  return n;
+}
+
+/**
+ * Function to aggregate the points of a render snapshot not yet aggregated on
+ * the coarse levels of detail.
+ */
+static void
+graphic_levels_update (Graphic *graphic,        ///< Graphic struct.
+                       Snapshot *s)     ///< Render snapshot.
+{
+  GraphicLevel *level;
+  Point3D *p, *end;
+  unsigned int i, j, l, nx, ny, nz;
+
+  // Resetting the levels on a new run
+  if (s->run != graphic->level_run || s->npoints < graphic->level_next)
+    {
+      graphic->level_run = s->run;
+      graphic->level_next = 0;
+      for (l = 1; l <= GRAPHIC_LEVELS; ++l)
+        {
+          level = graphic->level + l - 1;
+          nx = (length >> l) + 1;
+          ny = (width >> l) + 1;
+          nz = (height >> l) + 1;
+          level->nvoxels = nx * ny * nz;
+          level->voxel = (unsigned char *)
+            g_realloc (level->voxel, (level->nvoxels + 7) / 8);
+          memset (level->voxel, 0, (level->nvoxels + 7) / 8);
+          level->npoints = level->vbo_npoints = 0;
+        }
+    }
+
+  // Adding a point per new occupied voxel, on the voxel center
+  for (l = 1; l <= GRAPHIC_LEVELS; ++l)
+    {
+      level = graphic->level + l - 1;
+      nx = (length >> l) + 1;
+      ny = (width >> l) + 1;
+      for (p = s->point + graphic->level_next, end = s->point + s->npoints;
+           p < end; ++p)
+        {
+          i = ((p->r[2] >> l) * ny + (p->r[1] >> l)) * nx + (p->r[0] >> l);
+          if (level->voxel[i / 8] & (1 << (i % 8)))
+            continue;
+          level->voxel[i / 8] |= 1 << (i % 8);
+          if (level->npoints == level->nallocated)
+            {
+              level->nallocated = 2 * level->npoints + GRAPHIC_POINTS;
+              level->point = (Point3D *)
+                g_realloc (level->point, level->nallocated * sizeof (Point3D));
+            }
+          for (j = 0; j < 3; ++j)
+            level->point[level->npoints].r[j]
+              = ((p->r[j] >> l) << l) + (1 << (l - 1));
+          level->point[level->npoints].c = p->c;
+          level->point[level->npoints].hidden = 0;
+          ++level->npoints;
+        }
+    }
+  graphic->level_next = s->npoints;
+}
+
+/**
+ * Function to select the level of detail to draw. The full detail is drawn
+ * unless the view is changing. Then the finest level with voxels not smaller
+ * than a pixel and not exceeding GRAPHIC_LOD_POINTS points is selected.
+ *
+ * \return level of detail, 0 on full detail.
+ */
+static unsigned int
+graphic_level (Graphic *graphic,        ///< Graphic struct.
+               float scale)     ///< Pixels per site on the window.
+{
+  unsigned int l;
+  if (!graphic->interacting)
+    return 0;
+  if (scale >= 1.f && graphic->vbo_npoints <= GRAPHIC_LOD_POINTS)
+    return 0;
+  for (l = 1; l < GRAPHIC_LEVELS; ++l, scale *= 2.f)
+    if (2.f * scale >= 1.f
+        && graphic->level[l - 1].npoints <= GRAPHIC_LOD_POINTS)
+      break;
+  return l;
+}
+
+/**
+ * Function to draw a coarse level of detail.
+ */
+static void
+graphic_level_draw (Graphic *graphic,   ///< Graphic struct.
+                    unsigned int l,     ///< Level of detail.
+                    float scale)        ///< Pixels per site on the window.
+{
+  GraphicLevel *level;
+  level = graphic->level + l - 1;
+
+  // Uploading the voxels added since the last draw of the level
+  glBindBuffer (GL_ARRAY_BUFFER, level->vbo);
+  if (level->npoints > level->vbo_nallocated)
+    {
+      level->vbo_nallocated = 2 * level->npoints;
+      glBufferData (GL_ARRAY_BUFFER, level->vbo_nallocated * sizeof (Point3D),
+                    NULL, GL_DYNAMIC_DRAW);
+      level->vbo_npoints = 0;
+    }
+  if (level->npoints > level->vbo_npoints)
+    glBufferSubData (GL_ARRAY_BUFFER, level->vbo_npoints * sizeof (Point3D),
+                     (level->npoints - level->vbo_npoints) * sizeof (Point3D),
+                     level->point + level->vbo_npoints);
+  level->vbo_npoints = level->npoints;
+
+  // Drawing a point per voxel covering its size on the window
+  scale *= 1 << l;
+  if (scale < 1.f)
+    scale = 1.f;
+  glUniform1f (graphic->uniform_3D_point_size, ceilf (scale));
+  graphic_draw_points (graphic, level->vao, level->vbo, GL_POINTS,
+                       level->npoints);
+  glUniform1f (graphic->uniform_3D_point_size, 1.f);
+}
+
+/**
+ * Function to check if the fractal is drawn as a texture of the medium.
+ *
+ * \return 1 on a 2D fractal fitting on a texture, 0 otherwise.
+ */
+static inline unsigned int
+graphic_textured (Graphic *graphic)     ///< Graphic struct.
+{
+  return !fractal_3D && width <= (unsigned int) graphic->max_texture_size
+    && height <= (unsigned int) graphic->max_texture_size;
+}
+
+/**
+ * Function to update the texture of a 2D medium. The rows with points added
+ * since the last update are marked on a dirty rows bitmap and every
+ * contiguous run of dirty rows is uploaded.
+ */
+static void
+graphic_update_medium (Graphic *graphic,        ///< Graphic struct.
+                       Snapshot *s)     ///< Render snapshot.
+{
+  Point3D *p;
+  unsigned int i, y, ymin, ymax;
+
+  // Allocating a blank texture on a new run or medium
+  glActiveTexture (GL_TEXTURE0);
+  glBindTexture (GL_TEXTURE_2D, graphic->texture_medium);
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+  if (s->run != graphic->texture_run || s->npoints < graphic->texture_npoints
+      || width != graphic->texture_width || height != graphic->texture_height)
+    {
+      graphic->texture_run = s->run;
+      graphic->texture_npoints = 0;
+      graphic->texture_width = width;
+      graphic->texture_height = height;
+      graphic->texels
+        = (GLubyte *) g_realloc (graphic->texels, width * height);
+      memset (graphic->texels, 0, width * height);
+      graphic->dirty = (GLubyte *) g_realloc (graphic->dirty, height);
+      memset (graphic->dirty, 0, height);
+      glTexImage2D (GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
+                    GL_LUMINANCE, GL_UNSIGNED_BYTE, graphic->texels);
+    }
+
+  // Marking the dirty rows
+  ymin = height;
+  ymax = 0;
+  for (i = graphic->texture_npoints, p = s->point + i; i < s->npoints;
+       ++i, ++p)
+    {
+      graphic->texels[p->r[1] * width + p->r[0]] = p->c;
+      graphic->dirty[p->r[1]] = 1;
+      if (p->r[1] < ymin)
+        ymin = p->r[1];
+      if (p->r[1] > ymax)
+        ymax = p->r[1];
+    }
+  graphic->texture_npoints = s->npoints;
+
+  // Uploading every contiguous run of dirty rows
+  for (y = ymin; y <= ymax;)
+    {
+      if (!graphic->dirty[y])
+        {
+          ++y;
+          continue;
+        }
+      for (i = y; i <= ymax && graphic->dirty[i]; ++i)
+        graphic->dirty[i] = 0;
+      glTexSubImage2D (GL_TEXTURE_2D, 0, 0, y, width, i - y,
+                       GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                       graphic->texels + y * width);
+      y = i;
+    }
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+}
+
+/**
+ * Function to draw a 2D fractal as a quad with the texture of the medium.
+ */
+static void
+graphic_render_medium (Graphic *graphic)        ///< Graphic struct.
+{
+  glUseProgram (graphic->program_2D);
+  glActiveTexture (GL_TEXTURE0);
+  glBindTexture (GL_TEXTURE_2D, graphic->texture_medium);
+  glActiveTexture (GL_TEXTURE1);
+  glBindTexture (GL_TEXTURE_2D, graphic->texture_palette);
+  glActiveTexture (GL_TEXTURE0);
+  if (graphic->vao_quad)
+    {
+      glBindVertexArray (graphic->vao_quad);
+      glDrawArrays (GL_TRIANGLE_STRIP, 0, 4);
+      glBindVertexArray (0);
+      return;
+    }
+  glBindBuffer (GL_ARRAY_BUFFER, graphic->vbo_quad);
+  glEnableVertexAttribArray (graphic->attribute_2D_position);
+  glVertexAttribPointer (graphic->attribute_2D_position,
+                         2, GL_FLOAT, GL_FALSE, 0, NULL);
+  glDrawArrays (GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray (graphic->attribute_2D_position);
+}
+
 /**
  * Function to init the graphic data.
 
@@ -68,26 +366,76 @@ graphic_init (Graphic *graphic, ///< Draw struct.
     0., 0, 0., 0.,
     0., 0., 0., 1.
   };
+  // Unit square, scaled to the medium sizes by the projection matrix
+  const Point3D square_vertices[4] = {
+    {{0, 0, 0}, 0, 0},
+    {{1, 0, 0}, 0, 0},
+    {{1, 1, 0}, 0, 0},
+    {{0, 1, 0}, 0, 0}
+  };
+  const GLfloat palette[16][3] = {
+    {0., 0., 0.},
+    {1., 0., 0.},
+    {0., 1., 0.},
+    {0., 0., 1.},
+    {0.5, 0.5, 0.},
+    {0.5, 0., 0.5},
+    {0., 0.5, 0.5},
+    {0.5, 0.25, 0.25},
+    {0.25, 0.5, 0.25},
+    {0.25, 0.25, 0.5},
+    {0.75, 0.25, 0.},
+    {0.75, 0., 0.25},
+    {0.25, 0.75, 0.},
+    {0., 0.75, 0.25},
+    {0.25, 0., 0.75},
+    {0., 0.25, 0.75}
+  };
+  // Unit quad, covering the 2D medium
+  const GLfloat quad_vertices[8] = { 0., 0., 1., 0., 0., 1., 1., 1. };
+  const char *vs_2D_source =
+    "attribute highp vec2 position;"
+    "varying highp vec2 t_position;"
+    "void main ()"
+    "{gl_Position = vec4 (2.f * position - 1.f, 0.f, 1.f);"
+    "t_position = position;}";
+  const char *fs_2D_source =
+    "varying highp vec2 t_position;"
+    "uniform lowp sampler2D medium;"
+    "uniform lowp sampler2D palette;"
+    "void main ()"
+    "{gl_FragColor = texture2D (palette, vec2 (texture2D (medium, t_position).r"
+    " * (255.f / 16.f) + 1.f / 32.f, 0.5f));}";
   const char *vs_3D_source =
     "attribute highp vec3 position;"
-    "attribute lowp vec3 color;"
+    "attribute lowp float color;"
     "varying lowp vec3 fcolor;"
     "uniform highp mat4 matrix;"
+    "uniform lowp vec3 palette[16];"
+    "uniform highp float point_size;"
     "void main ()"
-    "{gl_Position = matrix * vec4 (position, 1.f); fcolor = color;}";
+    "{gl_Position = matrix * vec4 (position, 1.f);"
+    "gl_PointSize = point_size; fcolor = palette[int (color)];}";
   const char *fs_source =
     "varying lowp vec3 fcolor;"
     "void main () {gl_FragColor = vec4 (fcolor, 1.f);}";
   const char *vertex_name = "position";
   const char *color_name = "color";
   const char *matrix_name = "matrix";
+  const char *palette_name = "palette";
+  const char *medium_name = "medium";
+  const char *point_size_name = "point_size";
   // GLSL version
   const char *version = "#version 120\n";       // OpenGL 2.1
   const char *vs_3D_sources[3] = { version, INIT_GL_GLES, vs_3D_source };
   const char *fs_sources[3] = { version, INIT_GL_GLES, fs_source };
+  const char *vs_2D_sources[3] = { version, INIT_GL_GLES, vs_2D_source };
+  const char *fs_2D_sources[3] = { version, INIT_GL_GLES, fs_2D_source };
+  GLubyte palette_texels[16][4];
   const char *error_message;
   GLint k;
   GLuint vs, fs;
+  unsigned int i;
 
 #if DEBUG
   printf ("graphic_init: start\n");
@@ -160,8 +508,193 @@ graphic_init (Graphic *graphic, ///< Draw struct.
       goto exit_on_error;
     }
 
+  graphic->uniform_3D_palette
+    = glGetUniformLocation (graphic->program_3D, palette_name);
+  if (graphic->uniform_3D_palette == -1)
+    {
+      error_message = "could not bind uniform";
+      goto exit_on_error;
+    }
+  graphic->uniform_3D_point_size
+    = glGetUniformLocation (graphic->program_3D, point_size_name);
+  if (graphic->uniform_3D_point_size == -1)
+    {
+      error_message = "could not bind uniform";
+      goto exit_on_error;
+    }
+  glUseProgram (graphic->program_3D);
+  glUniform3fv (graphic->uniform_3D_palette, 16, (const GLfloat *) palette);
+  glUniform1f (graphic->uniform_3D_point_size, 1.f);
+  // The point size is set on the vertex shader
+  if (epoxy_is_desktop_gl ())
+    glEnable (GL_PROGRAM_POINT_SIZE);
+
   memcpy (graphic->projection_matrix, projection_matrix, 16 * sizeof (GLfloat));
 
+#if DEBUG
+  printf ("graphic_init: creating the points vertex buffer\n");
+  fflush (stdout);
+#endif
+  glGenBuffers (1, &graphic->vbo_points);
+  graphic->vbo_npoints = graphic->vbo_nallocated = graphic->vbo_run
+    = graphic->vbo_next = graphic->vbo_nhidden = graphic->nexposed = 0;
+  graphic->exposed = NULL;
+
+#if DEBUG
+  printf ("graphic_init: creating the bounding box vertex buffer\n");
+  fflush (stdout);
+#endif
+  glGenBuffers (1, &graphic->vbo_square);
+  glBindBuffer (GL_ARRAY_BUFFER, graphic->vbo_square);
+  glBufferData (GL_ARRAY_BUFFER, sizeof (square_vertices), square_vertices,
+                GL_STATIC_DRAW);
+
+  // Coarse levels of detail
+  for (i = 0; i < GRAPHIC_LEVELS; ++i)
+    {
+      graphic->level[i].point = NULL;
+      graphic->level[i].voxel = NULL;
+      graphic->level[i].npoints = graphic->level[i].nallocated
+        = graphic->level[i].vbo_npoints = graphic->level[i].vbo_nallocated
+        = 0;
+      glGenBuffers (1, &graphic->level[i].vbo);
+      graphic->level[i].vao = 0;
+    }
+  graphic->level_next = graphic->level_run = graphic->interacting = 0;
+  graphic->update = 1;
+
+  // Vertex arrays keeping the constant attributes of the buffers
+  graphic->vao_square = graphic->vao_points = 0;
+  if (GL_HAVE_VAO)
+    {
+      glGenVertexArrays (1, &graphic->vao_square);
+      glBindVertexArray (graphic->vao_square);
+      graphic_attributes (graphic, graphic->vbo_square);
+      glGenVertexArrays (1, &graphic->vao_points);
+      glBindVertexArray (graphic->vao_points);
+      graphic_attributes (graphic, graphic->vbo_points);
+      for (i = 0; i < GRAPHIC_LEVELS; ++i)
+        {
+          glGenVertexArrays (1, &graphic->level[i].vao);
+          glBindVertexArray (graphic->level[i].vao);
+          graphic_attributes (graphic, graphic->level[i].vbo);
+        }
+      glBindVertexArray (0);
+    }
+
+#if DEBUG
+  printf ("graphic_init: compiling 2D medium shaders\n");
+  fflush (stdout);
+#endif
+  vs = glCreateShader (GL_VERTEX_SHADER);
+  glShaderSource (vs, 3, vs_2D_sources, NULL);
+  glCompileShader (vs);
+  glGetShaderiv (vs, GL_COMPILE_STATUS, &k);
+  if (!k)
+    {
+      error_message = "unable to compile the 2D medium vertex shader";
+      goto exit_on_error;
+    }
+  fs = glCreateShader (GL_FRAGMENT_SHADER);
+  glShaderSource (fs, 3, fs_2D_sources, NULL);
+  glCompileShader (fs);
+  glGetShaderiv (fs, GL_COMPILE_STATUS, &k);
+  if (!k)
+    {
+      glDeleteShader (vs);
+      error_message = "unable to compile the 2D medium fragment shader";
+      goto exit_on_error;
+    }
+  graphic->program_2D = glCreateProgram ();
+  glAttachShader (graphic->program_2D, vs);
+  glAttachShader (graphic->program_2D, fs);
+  glLinkProgram (graphic->program_2D);
+  glDeleteShader (vs);
+  glDeleteShader (fs);
+  glGetProgramiv (graphic->program_2D, GL_LINK_STATUS, &k);
+  if (!k)
+    {
+      error_message = "unable to link the program 2D medium";
+      goto exit_on_error;
+    }
+  graphic->attribute_2D_position
+    = glGetAttribLocation (graphic->program_2D, vertex_name);
+  if (graphic->attribute_2D_position == -1)
+    {
+      error_message = "could not bind attribute";
+      goto exit_on_error;
+    }
+  graphic->uniform_2D_medium
+    = glGetUniformLocation (graphic->program_2D, medium_name);
+  graphic->uniform_2D_palette
+    = glGetUniformLocation (graphic->program_2D, palette_name);
+  if (graphic->uniform_2D_medium == -1 || graphic->uniform_2D_palette == -1)
+    {
+      error_message = "could not bind texture uniform";
+      goto exit_on_error;
+    }
+  glUseProgram (graphic->program_2D);
+  glUniform1i (graphic->uniform_2D_medium, 0);
+  glUniform1i (graphic->uniform_2D_palette, 1);
+
+#if DEBUG
+  printf ("graphic_init: creating the 2D medium textures\n");
+  fflush (stdout);
+#endif
+  glGetIntegerv (GL_MAX_TEXTURE_SIZE, &graphic->max_texture_size);
+  // The palette index 0 is an empty site, drawn as the white background
+  for (i = 0; i < 16; ++i)
+    {
+      palette_texels[i][0] = 255.f * palette[i][0];
+      palette_texels[i][1] = 255.f * palette[i][1];
+      palette_texels[i][2] = 255.f * palette[i][2];
+      palette_texels[i][3] = 255;
+    }
+  palette_texels[0][0] = palette_texels[0][1] = palette_texels[0][2] = 255;
+  glActiveTexture (GL_TEXTURE1);
+  glGenTextures (1, &graphic->texture_palette);
+  glBindTexture (GL_TEXTURE_2D, graphic->texture_palette);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, 16, 1, 0, GL_RGBA,
+                GL_UNSIGNED_BYTE, palette_texels);
+  glActiveTexture (GL_TEXTURE0);
+  glGenTextures (1, &graphic->texture_medium);
+  glBindTexture (GL_TEXTURE_2D, graphic->texture_medium);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  graphic->texels = graphic->dirty = NULL;
+  graphic->texture_width = graphic->texture_height = graphic->texture_npoints
+    = graphic->texture_run = 0;
+  glGenBuffers (1, &graphic->vbo_quad);
+  glBindBuffer (GL_ARRAY_BUFFER, graphic->vbo_quad);
+  glBufferData (GL_ARRAY_BUFFER, sizeof (quad_vertices), quad_vertices,
+                GL_STATIC_DRAW);
+  graphic->vao_quad = 0;
+  if (GL_HAVE_VAO)
+    {
+      glGenVertexArrays (1, &graphic->vao_quad);
+      glBindVertexArray (graphic->vao_quad);
+      glEnableVertexAttribArray (graphic->attribute_2D_position);
+      glVertexAttribPointer (graphic->attribute_2D_position,
+                             2, GL_FLOAT, GL_FALSE, 0, NULL);
+      glBindVertexArray (0);
+    }
+  for (i = 0; i < GRAPHIC_PBOS; ++i)
+    {
+      graphic->pbo[i] = 0;
+      graphic->pbo_fence[i] = NULL;
+      graphic->pbo_frame[i] = NULL;
+      graphic->pbo_state[i] = GRAPHIC_PBO_FREE;
+    }
+  graphic->pbo_next = 0;
+  if (GL_HAVE_PBO)
+    glGenBuffers (GRAPHIC_PBOS, graphic->pbo);
+
 #if DEBUG
   printf ("graphic_init: initing logo\n");
   fflush (stdout);
@@ -214,41 +747,178 @@ exit_on_error:
 void
 graphic_destroy (Graphic *graphic)      ///< Graphic struct.
 {
+  unsigned int i;
 #if DEBUG
   printf ("graphic_destroy: start\n");
   fflush (stdout);
 #endif
+  graphic_save_wait (graphic);
+  glDeleteBuffers (GRAPHIC_PBOS, graphic->pbo);
   text_destroy (graphic->text);
   image_destroy (graphic->logo);
+  if (graphic->vao_square)
+    {
+      glDeleteVertexArrays (1, &graphic->vao_quad);
+      glDeleteVertexArrays (1, &graphic->vao_points);
+      glDeleteVertexArrays (1, &graphic->vao_square);
+    }
+  glDeleteBuffers (1, &graphic->vbo_quad);
+  glDeleteTextures (1, &graphic->texture_medium);
+  glDeleteTextures (1, &graphic->texture_palette);
+  glDeleteProgram (graphic->program_2D);
+  g_free (graphic->dirty);
+  g_free (graphic->texels);
+  g_free (graphic->exposed);
+  for (i = 0; i < GRAPHIC_LEVELS; ++i)
+    {
+      if (graphic->level[i].vao)
+        glDeleteVertexArrays (1, &graphic->level[i].vao);
+      glDeleteBuffers (1, &graphic->level[i].vbo);
+      g_free (graphic->level[i].voxel);
+      g_free (graphic->level[i].point);
+    }
+  glDeleteBuffers (1, &graphic->vbo_points);
+  glDeleteBuffers (1, &graphic->vbo_square);
 #if DEBUG
   printf ("graphic_destroy: end\n");
   fflush (stdout);
 #endif
 }
 
+/**
+ * Function to upload the exposed points of a render snapshot added since the
+ * last update. The buffer grows geometrically and is compacted uploading
+ * again the exposed points on a new run or when many points got hidden.
+ */
+static void
+graphic_update_points (Graphic *graphic,        ///< Graphic struct.
+                       Snapshot *s)     ///< Render snapshot.
+{
+  unsigned int n;
+  glBindBuffer (GL_ARRAY_BUFFER, graphic->vbo_points);
+  if (s->run != graphic->vbo_run || s->npoints < graphic->vbo_next
+      || GRAPHIC_COMPACTION * (s->nhidden - graphic->vbo_nhidden)
+      > graphic->vbo_npoints)
+    {
+      graphic->vbo_run = s->run;
+      graphic->vbo_next = graphic->vbo_npoints = 0;
+      graphic->vbo_nhidden = s->nhidden;
+    }
+  n = graphic_exposed (graphic, s);
+  if (graphic->vbo_npoints + n > graphic->vbo_nallocated)
+    {
+      if (graphic->vbo_npoints)
+        {
+          graphic->vbo_next = graphic->vbo_npoints = 0;
+          graphic->vbo_nhidden = s->nhidden;
+          n = graphic_exposed (graphic, s);
+        }
+      graphic->vbo_nallocated = 2 * n;
+      if (graphic->vbo_nallocated < GRAPHIC_POINTS)
+        graphic->vbo_nallocated = GRAPHIC_POINTS;
+      glBufferData (GL_ARRAY_BUFFER, graphic->vbo_nallocated
+                    * sizeof (Point3D), NULL, GL_DYNAMIC_DRAW);
+    }
+  if (n)
+    glBufferSubData (GL_ARRAY_BUFFER, graphic->vbo_npoints * sizeof (Point3D),
+                     n * sizeof (Point3D), graphic->exposed);
+  graphic->vbo_npoints += n;
+  graphic->vbo_next = s->npoints;
+  if (fractal_3D)
+    graphic_levels_update (graphic, s);
+}
+
+/**
+ * Function to upload the last render snapshot. It is only needed when the
+ * fractal changed, not when the view changed.
+ */
+void
+graphic_update (Graphic *graphic)       ///< Graphic struct.
+{
+  Snapshot *s;
+  gint64 span;
+
+#if DEBUG
+  printf ("graphic_update: start\n");
+  fflush (stdout);
+#endif
+  span = g_get_monotonic_time ();
+  graphic->update = 0;
+  s = snapshot_acquire ();
+  if (graphic_textured (graphic))
+    graphic_update_medium (graphic, s);
+  else
+    graphic_update_points (graphic, s);
+  snapshot_release ();
+  trace_span ("graphic_update", span);
+
+#if DEBUG
+  printf ("graphic_update: end\n");
+  fflush (stdout);
+#endif
+}
+
+/**
+ * Function the set the perspective of a point.
+ */
+static void
+graphic_perspective (Graphic *graphic,  ///< Graphic struct.
+                     int x,     ///< Point x-coordinate.
+                     int y,     ///< Point y-coordinate.
+                     int z,     ///< Point z-coordinate.
+                     float *X,  ///< Perspective X-coordinate.
+                     float *Y)  ///< Perspective Y-coordinate.
+{
+  float cp, sp, st, ct;
+  sincosf (graphic->phi, &sp, &cp);
+  sincosf (graphic->theta, &st, &ct);
+  *X = x * cp - y * sp;
+  *Y = z * st + (y * cp + x * sp) * ct;
+}
+
+/**
+ * Function to set the view perspective angles and the projected bounds of the
+ * 3D medium.
+ */
+void
+graphic_view (Graphic *graphic, ///< Graphic struct.
+              float phid,       ///< Horizontal perspective angle (in degrees).
+              float thetad)     ///< Vertical perspective angle (in degrees).
+{
+  float k1, k2;
+  graphic->phi = phid * M_PI / 180.;
+  graphic->theta = thetad * M_PI / 180.;
+  if (fractal_3D)
+    {
+      graphic_perspective (graphic, 0, 0, 0, &k1, &k2);
+      graphic->xmin = k1;
+      graphic_perspective (graphic, length, width, 0, &k1, &k2);
+      graphic->xmax = k1;
+      graphic_perspective (graphic, length, 0, 0, &k1, &k2);
+      graphic->ymin = k2;
+      graphic_perspective (graphic, 0, width, height, &k1, &k2);
+      graphic->ymax = k2;
+    }
+}
+
 /**
  * Function to draw the fractal.
  */
 void
 graphic_render (Graphic *graphic)       ///< Graphic struct.
 {
-  // Rectangle matrix
-  const Point3D square_vertices[4] = {
-    {{0., 0., 0.}, {0., 0., 0.}},
-    {{length, 0., 0.}, {0., 0., 0.}},
-    {{length, width, 0.}, {0., 0., 0.}},
-    {{0., width, 0.}, {0., 0., 0.}}
-  };
-  const GLushort square_indices[4] = { 0, 1, 2, 3 };
   const GLfloat black[4] = { 0., 0., 0., 1. };
   const char *str_version = "Fractal 3.4.24";
-  float cp, sp, ct, st, w, h, sx, sy;
-  GLuint vbo_square, ibo_square, vbo_points;
+  GLfloat square_matrix[16];
+  float cp, sp, ct, st, w, h, sx, sy, scale;
+  unsigned int i, l;
+  gint64 span;
 
 #if DEBUG
   printf ("graphic_render: start\n");
   fflush (stdout);
 #endif
+  span = g_get_monotonic_time ();
 
   // Drawing a white background
   glClearColor (1., 1., 1., 0.);
@@ -268,6 +938,17 @@ graphic_render (Graphic *graphic)       ///< Graphic struct.
   fflush (stdout);
 #endif
 
+  // Uploading the new render snapshot
+  if (graphic->update)
+    graphic_update (graphic);
+
+  // Drawing 2D fractals as a texture of the medium when it fits
+  if (graphic_textured (graphic))
+    {
+      graphic_render_medium (graphic);
+      goto end_draw;
+    }
+
   // Checking if 3D or 2D fractal
   glUseProgram (graphic->program_3D);
   if (fractal_3D)
@@ -277,6 +958,7 @@ graphic_render (Graphic *graphic)       ///< Graphic struct.
       sincosf (graphic->theta, &st, &ct);
       w = graphic->xmax - graphic->xmin;
       h = graphic->ymax - graphic->ymin;
+      scale = fminf (window_width / w, window_height / h);
       graphic->projection_matrix[0] = 2. * cp / w;
       graphic->projection_matrix[1] = 2. * ct * sp / h;
       graphic->projection_matrix[4] = -2. * sp / w;
@@ -284,71 +966,46 @@ graphic_render (Graphic *graphic)       ///< Graphic struct.
       graphic->projection_matrix[9] = 2. * st / h;
       graphic->projection_matrix[12] = -1.;
       graphic->projection_matrix[13] = -1. - 2. * graphic->ymin / h;
+
+      // Drawing a black rectangle scaling the unit square to the medium
+      for (i = 0; i < 4; ++i)
+        {
+          square_matrix[i] = length * graphic->projection_matrix[i];
+          square_matrix[4 + i] = width * graphic->projection_matrix[4 + i];
+        }
+      memcpy (square_matrix + 8, graphic->projection_matrix + 8,
+              8 * sizeof (GLfloat));
       glUniformMatrix4fv (graphic->uniform_3D_matrix, 1, GL_FALSE,
-                          graphic->projection_matrix);
-
-      // Drawing a black rectangle
-      glGenBuffers (1, &vbo_square);
-      glBindBuffer (GL_ARRAY_BUFFER, vbo_square);
-      glBufferData (GL_ARRAY_BUFFER, sizeof (square_vertices), square_vertices,
-                    GL_DYNAMIC_DRAW);
-      glGenBuffers (1, &ibo_square);
-      glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, ibo_square);
-      glBufferData (GL_ELEMENT_ARRAY_BUFFER, sizeof (square_indices),
-                    square_indices, GL_DYNAMIC_DRAW);
-      glBindBuffer (GL_ARRAY_BUFFER, vbo_square);
-      glEnableVertexAttribArray (graphic->attribute_3D_position);
-      glVertexAttribPointer (graphic->attribute_3D_position,
-                             3, GL_FLOAT, GL_FALSE, sizeof (Point3D), NULL);
-      glEnableVertexAttribArray (graphic->attribute_3D_color);
-      glVertexAttribPointer (graphic->attribute_3D_color,
-                             3,
-                             GL_FLOAT,
-                             GL_FALSE,
-                             sizeof (Point3D),
-                             (GLvoid *) offsetof (Point3D, c));
-      glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, ibo_square);
-      glDrawElements (GL_LINE_LOOP, 4, GL_UNSIGNED_SHORT, 0);
-      glDeleteBuffers (1, &ibo_square);
-      glDeleteBuffers (1, &vbo_square);
-      glDisableVertexAttribArray (graphic->attribute_3D_color);
-      glDisableVertexAttribArray (graphic->attribute_3D_position);
+                          square_matrix);
+      graphic_draw_points (graphic, graphic->vao_square, graphic->vbo_square,
+                           GL_LINE_LOOP, 4);
     }
   else
     {
       // Projection matrix
+      scale = 1.f;
       graphic->projection_matrix[0] = 2. / width;
       graphic->projection_matrix[5] = 2. / height;
       graphic->projection_matrix[12] = graphic->projection_matrix[13] = -1.;
       graphic->projection_matrix[1] = graphic->projection_matrix[4]
         = graphic->projection_matrix[9] = 0.;
-      glUniformMatrix4fv (graphic->uniform_3D_matrix, 1, GL_FALSE,
-                          graphic->projection_matrix);
     }
+  glUniformMatrix4fv (graphic->uniform_3D_matrix, 1, GL_FALSE,
+                      graphic->projection_matrix);
 
 #if DEBUG
   printf ("graphic_render: drawing the fractal points\n");
   fflush (stdout);
 #endif
 
-  // Drawing the fractal points
-  glGenBuffers (1, &vbo_points);
-  glBindBuffer (GL_ARRAY_BUFFER, vbo_points);
-  glBufferData (GL_ARRAY_BUFFER, npoints * sizeof (Point3D), point,
-                GL_DYNAMIC_DRAW);
-  glEnableVertexAttribArray (graphic->attribute_3D_position);
-  glVertexAttribPointer (graphic->attribute_3D_position,
-                         3, GL_FLOAT, GL_FALSE, sizeof (Point3D), NULL);
-  glEnableVertexAttribArray (graphic->attribute_3D_color);
-  glVertexAttribPointer (graphic->attribute_3D_color,
-                         3,
-                         GL_FLOAT,
-                         GL_FALSE,
-                         sizeof (Point3D), (GLvoid *) offsetof (Point3D, c));
-  glDrawArrays (GL_POINTS, 0, npoints);
-  glDeleteBuffers (1, &vbo_points);
-  glDisableVertexAttribArray (graphic->attribute_3D_color);
-  glDisableVertexAttribArray (graphic->attribute_3D_position);
+  // Drawing the fractal points, or a coarse level of detail on changing the
+  // 3D view
+  l = fractal_3D ? graphic_level (graphic, scale) : 0;
+  if (l)
+    graphic_level_draw (graphic, l, scale);
+  else
+    graphic_draw_points (graphic, graphic->vao_points, graphic->vbo_points,
+                         GL_POINTS, graphic->vbo_npoints);
 
 end_draw:
 
@@ -382,6 +1039,9 @@ end_draw:
   printf ("graphic_render: displaying the draw\n");
   fflush (stdout);
 #endif
+  // Sending the saved frames read back by the GPU to the encoder thread
+  graphic_save_poll (graphic);
+  trace_span ("graphic_render", span);
 
 #if DEBUG
   printf ("graphic_render: end\n");
@@ -390,103 +1050,322 @@ end_draw:
 }
 
 /**
- * Function to save the draw in a PNG file.
+ * Function to encode a frame on a PNG file.
+ *
+ * \return 1 on success, 0 on error.
  */
-void
-graphic_save (char *file_name)  ///< File name.
+static int
+graphic_png (GraphicFrame *frame,       ///< GraphicFrame struct.
+             FILE *file)        ///< PNG file.
 {
   png_struct *png;
   png_info *info;
-  png_byte **row_pointers;
-  GLubyte *pixels;
-  FILE *file;
-  unsigned int i, row_bytes, pointers_bytes, pixels_bytes;
-
-#if DEBUG
-  printf ("graphic_save: start\n");
-  fflush (stdout);
-#endif
-
-  // Creating the PNG header
   png = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
   if (!png)
-    return;
+    return 0;
   info = png_create_info_struct (png);
   if (!info)
-    return;
-  file = fopen (file_name, "wb");
-  if (!file)
-    return;
-  if (setjmp (png_jmpbuf (png)))
     {
-      printf ("Error png_init_io\n");
-      exit (0);
+      png_destroy_write_struct (&png, NULL);
+      return 0;
     }
-  png_init_io (png, file);
   if (setjmp (png_jmpbuf (png)))
     {
-      printf ("Error png_set_IHDR\n");
-      exit (0);
+      png_destroy_write_struct (&png, &info);
+      return 0;
     }
+  png_init_io (png, file);
   png_set_IHDR (png,
                 info,
-                window_width,
-                window_height,
+                frame->width,
+                frame->height,
                 8,
                 PNG_COLOR_TYPE_RGBA,
                 PNG_INTERLACE_NONE,
                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-  if (setjmp (png_jmpbuf (png)))
-    {
-      printf ("Error png_write_info\n");
-      exit (0);
-    }
   png_write_info (png, info);
+  png_write_image (png, frame->row);
+  png_write_end (png, NULL);
+  png_destroy_write_struct (&png, &info);
+  return 1;
+}
 
-  // Getting the OpenGL pixels
-  glViewport (0, 0, window_width, window_height);
-  row_bytes = 4 * window_width;
-  pixels_bytes = row_bytes * window_height;
-  pixels = (GLubyte *) g_slice_alloc (pixels_bytes);
-  glReadPixels (0, 0, window_width, window_height, GL_RGBA, GL_UNSIGNED_BYTE,
-                pixels);
+/**
+ * Function to end the saving of a frame, showing the error message if any.
+ * It is called on the main loop as an idle function or, in batch mode, on the
+ * encoder thread.
+ *
+ * \return G_SOURCE_REMOVE.
+ */
+static gboolean
+graphic_saved (GraphicFrame *frame)     ///< GraphicFrame struct.
+{
+  Graphic *graphic;
+  unsigned int error;
+  error = (frame->error_message != NULL);
+  if (error)
+    show_error (frame->error_message);
+  graphic = frame->graphic;
+  g_free (frame->row);
+  g_free (frame->pixels);
+  g_free (frame->file_name);
+  g_slice_free1 (sizeof (GraphicFrame), frame);
+  g_mutex_lock (graphic->save_mutex);
+  graphic->nsave_errors += error;
+  --graphic->nsaving;
+  g_cond_broadcast (graphic->save_cond);
+  g_mutex_unlock (graphic->save_mutex);
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Function to encode a frame on a PNG file. It is the encoder thread
+ * function.
+ *
+ * \return NULL.
+ */
+static gpointer
+graphic_encode (GraphicFrame *frame)    ///< GraphicFrame struct.
+{
+  Graphic *graphic;
+  FILE *file;
+  unsigned int i, row_bytes;
+#if DEBUG
+  printf ("graphic_encode: start\n");
+  fflush (stdout);
+#endif
 
-  // Saving the pixels in the PNG order
-  pointers_bytes = window_height * sizeof (png_byte *);
-  row_pointers = (png_byte **) g_slice_alloc (pointers_bytes);
-  for (i = 0; i < window_height; ++i)
+  // Copying the pixels from the mapped pixel buffer, to be unmapped on the
+  // render thread
+  row_bytes = 4 * frame->width;
+  if (frame->data)
     {
-      row_pointers[i] = (png_byte *) g_slice_alloc (row_bytes);
-      memcpy (row_pointers[i], pixels + (window_height - 1 - i) * row_bytes,
-              row_bytes);
+      frame->pixels = (GLubyte *) g_malloc (row_bytes * frame->height);
+      memcpy (frame->pixels, frame->data, row_bytes * frame->height);
+      frame->data = NULL;
+      graphic = frame->graphic;
+      g_mutex_lock (graphic->save_mutex);
+      graphic->pbo_state[frame->pbo] = GRAPHIC_PBO_COPIED;
+      g_cond_broadcast (graphic->save_cond);
+      g_mutex_unlock (graphic->save_mutex);
     }
-  if (setjmp (png_jmpbuf (png)))
+  if (frame->error_message)
+    goto end;
+
+  // Referencing the rows in the PNG order, from the top row
+  frame->row = (GLubyte **) g_malloc (frame->height * sizeof (GLubyte *));
+  for (i = 0; i < frame->height; ++i)
+    frame->row[i] = frame->pixels + (frame->height - 1 - i) * row_bytes;
+
+  // Encoding the PNG file
+  file = fopen (frame->file_name, "wb");
+  if (!file)
+    frame->error_message = _("Unable to open the image file");
+  else
     {
-      printf ("Error png_write_image\n");
-      exit (0);
+      if (!graphic_png (frame, file))
+        frame->error_message = _("Unable to save the image file");
+      if (fclose (file) && !frame->error_message)
+        frame->error_message = _("Unable to save the image file");
     }
-  png_write_image (png, row_pointers);
 
-  // Freeing memory
-  for (i = 0; i < window_height; ++i)
-    g_slice_free1 (row_bytes, row_pointers[i]);
-  g_slice_free1 (pointers_bytes, row_pointers);
-  g_slice_free1 (pixels_bytes, pixels);
+  // Showing the errors on the main loop
+end:
+  if (batch)
+    graphic_saved (frame);
+  else
+    g_idle_add ((GSourceFunc) graphic_saved, frame);
+#if DEBUG
+  printf ("graphic_encode: end\n");
+  fflush (stdout);
+#endif
+  return NULL;
+}
 
-  // Saving the file
-  if (setjmp (png_jmpbuf (png)))
+/**
+ * Function to advance the read back of a saved frame on a pixel buffer. The
+ * buffer is mapped and sent to the encoder thread once the GPU ends the read
+ * back, and unmapped once the encoder thread copies the frame.
+ */
+static void
+graphic_save_pbo (Graphic *graphic,     ///< Graphic struct.
+                  unsigned int i,       ///< Pixel buffer index.
+                  unsigned int wait)
+                  ///< 1 to wait until the pixel buffer is free, 0 to poll.
+{
+  GraphicFrame *frame;
+  GLuint64 timeout;
+  unsigned int state;
+
+  timeout = wait ? G_MAXUINT64 : 0;
+  do
     {
-      printf ("Error png_write_end\n");
-      exit (0);
+      g_mutex_lock (graphic->save_mutex);
+      while (wait && graphic->pbo_state[i] == GRAPHIC_PBO_MAPPED)
+        g_cond_wait (graphic->save_cond, graphic->save_mutex);
+      state = graphic->pbo_state[i];
+      g_mutex_unlock (graphic->save_mutex);
+      switch (state)
+        {
+        case GRAPHIC_PBO_READING:
+
+          // Checking the GPU end of the read back
+          if (graphic->pbo_fence[i])
+            {
+              if (glClientWaitSync (graphic->pbo_fence[i],
+                                    GL_SYNC_FLUSH_COMMANDS_BIT, timeout)
+                  == GL_TIMEOUT_EXPIRED)
+                return;
+              glDeleteSync (graphic->pbo_fence[i]);
+              graphic->pbo_fence[i] = NULL;
+            }
+
+          // Mapping the frame and sending it to the encoder thread
+          frame = graphic->pbo_frame[i];
+          graphic->pbo_frame[i] = NULL;
+          glBindBuffer (GL_PIXEL_PACK_BUFFER, graphic->pbo[i]);
+          frame->data = (GLubyte *)
+            glMapBufferRange (GL_PIXEL_PACK_BUFFER, 0,
+                              4 * frame->width * frame->height,
+                              GL_MAP_READ_BIT);
+          glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+          if (frame->data)
+            state = GRAPHIC_PBO_MAPPED;
+          else
+            {
+              frame->error_message = _("Unable to save the image file");
+              state = GRAPHIC_PBO_FREE;
+            }
+          g_mutex_lock (graphic->save_mutex);
+          graphic->pbo_state[i] = state;
+          g_mutex_unlock (graphic->save_mutex);
+          g_thread_unref (g_thread_new ("graphic_encode",
+                                        (GThreadFunc) graphic_encode, frame));
+          break;
+
+        case GRAPHIC_PBO_COPIED:
+
+          // Unmapping the frame copied by the encoder thread
+          glBindBuffer (GL_PIXEL_PACK_BUFFER, graphic->pbo[i]);
+          glUnmapBuffer (GL_PIXEL_PACK_BUFFER);
+          glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+          state = GRAPHIC_PBO_FREE;
+          g_mutex_lock (graphic->save_mutex);
+          graphic->pbo_state[i] = state;
+          g_mutex_unlock (graphic->save_mutex);
+        }
     }
-  png_write_end (png, NULL);
-  fclose (file);
+  while (wait && state != GRAPHIC_PBO_FREE);
+}
 
-  // Freeing memory
-  png_destroy_write_struct (&png, &info);
+/**
+ * Function to save the draw in a PNG file. The pixels are read back
+ * asynchronously on the next of the pixel buffers, if available, to be mapped
+ * on a later frame, and encoded on a background thread.
+ */
+void
+graphic_save (Graphic *graphic, ///< Graphic struct.
+              char *file_name)  ///< File name.
+{
+  GraphicFrame *frame;
+  unsigned int i;
+
+#if DEBUG
+  printf ("graphic_save: start\n");
+  fflush (stdout);
+#endif
+
+  // Getting the OpenGL pixels
+  frame = (GraphicFrame *) g_slice_alloc (sizeof (GraphicFrame));
+  frame->graphic = graphic;
+  frame->file_name = g_strdup (file_name);
+  frame->data = frame->pixels = NULL;
+  frame->row = NULL;
+  frame->error_message = NULL;
+  frame->width = window_width;
+  frame->height = window_height;
+  g_mutex_lock (graphic->save_mutex);
+  ++graphic->nsaving;
+  g_mutex_unlock (graphic->save_mutex);
+  glViewport (0, 0, window_width, window_height);
+  if (graphic->pbo[0])
+    {
+      // Freeing the next pixel buffer, saved two frames ago
+      i = frame->pbo = graphic->pbo_next;
+      graphic->pbo_next = (i + 1) % GRAPHIC_PBOS;
+      graphic_save_pbo (graphic, i, 1);
+
+      // Reading back the pixels without waiting the GPU
+      glBindBuffer (GL_PIXEL_PACK_BUFFER, graphic->pbo[i]);
+      glBufferData (GL_PIXEL_PACK_BUFFER, 4 * window_width * window_height,
+                    NULL, GL_STREAM_READ);
+      glReadPixels (0, 0, window_width, window_height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, NULL);
+      glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+      if (GL_HAVE_SYNC)
+        graphic->pbo_fence[i] = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      graphic->pbo_frame[i] = frame;
+      graphic->pbo_state[i] = GRAPHIC_PBO_READING;
+    }
+  else
+    {
+      // Reading back the pixels directly and encoding the PNG file on a
+      // background thread
+      frame->pixels = (GLubyte *) g_malloc (4 * window_width * window_height);
+      glReadPixels (0, 0, window_width, window_height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, frame->pixels);
+      g_thread_unref (g_thread_new ("graphic_encode",
+                                    (GThreadFunc) graphic_encode, frame));
+    }
 
 #if DEBUG
   printf ("graphic_save: end\n");
   fflush (stdout);
 #endif
 }
+
+/**
+ * Function to send the saved frames read back by the GPU to the encoder
+ * thread and to unmap the frames copied, without waiting.
+ */
+void
+graphic_save_poll (Graphic *graphic)    ///< Graphic struct.
+{
+  unsigned int i;
+  for (i = 0; i < GRAPHIC_PBOS; ++i)
+    graphic_save_pbo (graphic, i, 0);
+}
+
+/**
+ * Function to wait the end of the saving of all the frames.
+ *
+ * \return number of frames failed to save since the last wait.
+ */
+unsigned int
+graphic_save_wait (Graphic *graphic)    ///< Graphic struct.
+{
+  unsigned int i, nerrors;
+
+  // Ending the read back of the frames on the pixel buffers
+  for (i = 0; i < GRAPHIC_PBOS; ++i)
+    graphic_save_pbo (graphic, i, 1);
+
+  // Waiting the encoder threads
+  g_mutex_lock (graphic->save_mutex);
+  while (graphic->nsaving)
+    {
+      if (batch)
+        g_cond_wait (graphic->save_cond, graphic->save_mutex);
+      else
+        {
+          // Running the pending idle functions showing the errors
+          g_mutex_unlock (graphic->save_mutex);
+          g_main_context_iteration (NULL, TRUE);
+          g_mutex_lock (graphic->save_mutex);
+        }
+    }
+  nerrors = graphic->nsave_errors;
+  graphic->nsave_errors = 0;
+  g_mutex_unlock (graphic->save_mutex);
+  return nerrors;
+}
@@ -35,6 +35,42 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef GRAPHIC__H
 #define GRAPHIC__H 1
 
+#define GL_HAVE_PBO \
+  (epoxy_gl_version () >= 30 \
+   || (epoxy_has_gl_extension ("GL_ARB_pixel_buffer_object") \
+       && epoxy_has_gl_extension ("GL_ARB_map_buffer_range")))
+///< Macro to check the pixel buffer objects to read back the frames.
+#define GL_HAVE_SYNC \
+  (epoxy_gl_version () >= 32 || epoxy_has_gl_extension ("GL_ARB_sync"))
+///< Macro to check the sync objects to poll the frames read back.
+
+///> An enum to define the states of a pixel buffer reading back a frame.
+enum GraphicPboState
+{
+  GRAPHIC_PBO_FREE = 0,         ///< Free pixel buffer.
+  GRAPHIC_PBO_READING = 1,      ///< Reading back a frame on the GPU.
+  GRAPHIC_PBO_MAPPED = 2,       ///< Mapped, copied by the encoder thread.
+  GRAPHIC_PBO_COPIED = 3        ///< Copied, waiting to be unmapped.
+};
+
+/**
+ * \struct GraphicLevel
+ * Struct to define a level of detail of the 3D points, aggregating them on
+ * cubic voxels.
+ */
+typedef struct
+{
+  Point3D *point;               ///< Array of the occupied voxels.
+  unsigned char *voxel;         ///< Array of bits of the occupied voxels.
+  unsigned int npoints;         ///< Number of occupied voxels.
+  unsigned int nallocated;      ///< Number of allocated occupied voxels.
+  unsigned int nvoxels;         ///< Number of voxels.
+  unsigned int vbo_npoints;     ///< Number of voxels uploaded to the buffer.
+  unsigned int vbo_nallocated;  ///< Number of voxels allocated on the buffer.
+  GLuint vbo;                   ///< Occupied voxels vertex buffer.
+  GLuint vao;                   ///< Occupied voxels vertex array.
+} GraphicLevel;
+
 /**
  * \struct Graphic
  * Struct to define graphic drawing data.
@@ -53,15 +89,84 @@ typedef struct
   GLint attribute_3D_position;  ///< 3D variable position.
   GLint attribute_3D_color;     ///< 3D variable color identifier.
   GLint uniform_3D_matrix;      ///< 3D constant matrix.
+  GLint uniform_3D_palette;     ///< 3D constant colors palette.
+  GLint uniform_3D_point_size;  ///< 3D constant point size.
+  GLint attribute_2D_position;  ///< 2D medium variable position.
+  GLint uniform_2D_medium;      ///< 2D medium texture constant.
+  GLint uniform_2D_palette;     ///< 2D palette texture constant.
+  GLint max_texture_size;       ///< Maximum size of the textures.
   GLuint program_3D;            ///< 3D program.
+  GLuint program_2D;            ///< 2D medium program.
+  GLuint vbo_square;            ///< Unit square vertex buffer.
+  GLuint vao_square;            ///< Unit square vertex array (0 if unavailable).
+  GLuint vbo_points;            ///< Fractal points vertex buffer.
+  GLuint vao_points;            ///< Fractal points vertex array.
+  unsigned int vbo_npoints;     ///< Number of points uploaded to the buffer.
+  unsigned int vbo_nallocated;  ///< Number of points allocated on the buffer.
+  unsigned int vbo_run;         ///< Simulation run of the uploaded points.
+  unsigned int vbo_next;        ///< Next snapshot point to upload.
+  unsigned int vbo_nhidden;     ///< Hidden snapshot points on the last upload.
+  Point3D *exposed;             ///< Array of exposed points to upload.
+  unsigned int nexposed;        ///< Number of allocated exposed points.
+  GLuint texture_medium;        ///< 2D medium texture.
+  GLuint texture_palette;       ///< 2D palette texture.
+  GLuint vbo_quad;              ///< 2D medium quad vertex buffer.
+  GLuint vao_quad;              ///< 2D medium quad vertex array.
+  GLubyte *texels;              ///< Palette indices of the 2D medium texture.
+  GLubyte *dirty;               ///< Dirty rows of the 2D medium texture.
+  unsigned int texture_width;   ///< Width of the 2D medium texture.
+  unsigned int texture_height;  ///< Height of the 2D medium texture.
+  unsigned int texture_npoints; ///< Number of points drawn on the texture.
+  unsigned int texture_run;     ///< Simulation run drawn on the texture.
+  GraphicLevel level[GRAPHIC_LEVELS];   ///< Coarse levels of detail.
+  unsigned int level_next;      ///< Next snapshot point to aggregate.
+  unsigned int level_run;       ///< Simulation run of the aggregated points.
+  unsigned int update;
+  ///< 1 on a new render snapshot to upload, 0 on drawing the uploaded data.
+  unsigned int interacting;
+  ///< 1 on changing the view, drawing a coarse level of detail, 0 otherwise.
+  GLuint pbo[GRAPHIC_PBOS];
+  ///< Pixel buffers to read back the saved frames (0 if unavailable).
+  GLsync pbo_fence[GRAPHIC_PBOS];
+  ///< Fences of the frames read back (NULL if unavailable).
+  struct GraphicFrame *pbo_frame[GRAPHIC_PBOS];
+  ///< Frames read back on the pixel buffers.
+  unsigned int pbo_state[GRAPHIC_PBOS];
+  ///< States of the pixel buffers (enum GraphicPboState).
+  unsigned int pbo_next;        ///< Next pixel buffer to read back a frame.
+  GMutex save_mutex[1];         ///< Mutex to lock the saving frames number.
+  GCond save_cond[1];           ///< Condition to wait the saved frames.
+  unsigned int nsaving;         ///< Number of frames being saved.
+  unsigned int nsave_errors;    ///< Number of frames failed to save.
 } Graphic;
 
+/**
+ * \struct GraphicFrame
+ * Struct to define a frame read back to be encoded on a PNG file.
+ */
+typedef struct GraphicFrame
+{
+  Graphic *graphic;             ///< Graphic struct.
+  char *file_name;              ///< PNG file name.
+  GLubyte *data;                ///< Mapped pixel buffer, NULL if unused.
+  GLubyte *pixels;              ///< RGBA pixels, from the bottom row.
+  GLubyte **row;                ///< Rows in the PNG order, into the pixels.
+  const char *error_message;    ///< Error message, NULL on success.
+  unsigned int width;           ///< Frame width.
+  unsigned int height;          ///< Frame height.
+  unsigned int pbo;             ///< Pixel buffer reading back the frame.
+} GraphicFrame;
+
 extern unsigned int window_width;
 extern unsigned int window_height;
 
 int graphic_init (Graphic * graphic, char *logo_name);
 void graphic_destroy (Graphic * graphic);
+void graphic_update (Graphic * graphic);
+void graphic_view (Graphic * graphic, float phid, float thetad);
 void graphic_render (Graphic * graphic);
-void graphic_save (char *file_name);
+void graphic_save (Graphic * graphic, char *file_name);
+void graphic_save_poll (Graphic * graphic);
+unsigned int graphic_save_wait (Graphic * graphic);
 
 #endif
@@ -148,6 +148,22 @@ error1:
   return image;
 }
 
+/**
+ * Function to set the vertex attributes of the image.
+ */
+static void
+image_attributes (Image *image) ///< Image struct.
+{
+  glBindBuffer (GL_ARRAY_BUFFER, image->vbo_texture);
+  glEnableVertexAttribArray (image->attribute_texture_position);
+  glVertexAttribPointer (image->attribute_texture_position,
+                         2, GL_FLOAT, GL_FALSE, 0, 0);
+  glBindBuffer (GL_ARRAY_BUFFER, image->vbo);
+  glEnableVertexAttribArray (image->attribute_texture);
+  glVertexAttribPointer (image->attribute_texture, 2, GL_FLOAT, GL_FALSE, 0, 0);
+  glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, image->ibo);
+}
+
 /**
  * Function to init the variables used to draw the image.
  *
@@ -282,6 +298,18 @@ image_init (Image *image)       ///< Image struct.
   glBufferData (GL_ARRAY_BUFFER, sizeof (image->square_texture),
                 image->square_texture, GL_STATIC_DRAW);
 
+  // The texture unit and the vertex attributes are constant
+  glUseProgram (image->program_texture);
+  glUniform1i (image->uniform_texture, 0);
+  image->vao = 0;
+  if (GL_HAVE_VAO)
+    {
+      glGenVertexArrays (1, &image->vao);
+      glBindVertexArray (image->vao);
+      image_attributes (image);
+      glBindVertexArray (0);
+    }
+
 #if DEBUG
   printf ("image_init: end\n");
   fflush (stdout);
@@ -308,6 +336,12 @@ image_destroy (Image *image)    ///< Image struct.
   fflush (stdout);
 #endif
 
+  if (image->vao)
+    glDeleteVertexArrays (1, &image->vao);
+  glDeleteBuffers (1, &image->vbo_texture);
+  glDeleteBuffers (1, &image->ibo);
+  glDeleteBuffers (1, &image->vbo);
+  glDeleteTextures (1, &image->id_texture);
   glDeleteProgram (image->program_texture);
   g_slice_free1 (image->size, image->image);
 
@@ -336,16 +370,15 @@ image_draw (Image *image,       ///< Image struct.
   image->matrix[13] = sp - 1.f + (2.f * y) / window_height;
   glUseProgram (image->program_texture);
   glUniformMatrix4fv (image->uniform_matrix, 1, GL_FALSE, image->matrix);
-  glUniform1i (image->uniform_texture, 0);
   glBindTexture (GL_TEXTURE_2D, image->id_texture);
-  glBindBuffer (GL_ARRAY_BUFFER, image->vbo_texture);
-  glEnableVertexAttribArray (image->attribute_texture_position);
-  glVertexAttribPointer (image->attribute_texture_position,
-                         2, GL_FLOAT, GL_FALSE, 0, 0);
-  glBindBuffer (GL_ARRAY_BUFFER, image->vbo);
-  glEnableVertexAttribArray (image->attribute_texture);
-  glVertexAttribPointer (image->attribute_texture, 2, GL_FLOAT, GL_FALSE, 0, 0);
-  glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, image->ibo);
+  if (image->vao)
+    {
+      glBindVertexArray (image->vao);
+      glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+      glBindVertexArray (0);
+      return;
+    }
+  image_attributes (image);
   glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
   glDisableVertexAttribArray (image->attribute_texture);
   glDisableVertexAttribArray (image->attribute_texture_position);
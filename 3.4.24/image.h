@@ -51,6 +51,14 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
   "#  define highp\n" \
   "#endif\n"
 
+/**
+ * Macro to check if the OpenGL vertex array objects are available.
+ */
+#define GL_HAVE_VAO \
+  (epoxy_gl_version () >= 30 \
+   || epoxy_has_gl_extension ("GL_ARB_vertex_array_object") \
+   || epoxy_has_gl_extension ("GL_OES_vertex_array_object"))
+
 /**
  * \struct Image
  * \brief A struct to define the image.
@@ -69,6 +77,7 @@ typedef struct
   GLuint vbo;                   ///< Vertices buffer object.
   GLuint ibo;                   ///< Indices buffer object.
   GLuint vbo_texture;           ///< Texture vertex buffer object.
+  GLuint vao;                   ///< Vertex array object (0 if unavailable).
   GLuint program_texture;       ///< Texture program.
   GLuint id_texture;            ///< Texture identifier.
   unsigned int width;           ///< Width.
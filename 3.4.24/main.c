@@ -35,8 +35,10 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
+#include <stdatomic.h>
 #include <unistd.h>
 #include <locale.h>
 #include <libintl.h>
@@ -61,6 +63,11 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "graphic.h"
 #include "draw.h"
 #include "simulator.h"
+#include "perf.h"
+#include "report.h"
+#include "bench.h"
+#include "trace.h"
+#include "offscreen.h"
 
 #if HAVE_FREEGLUT
 int window;                     ///< FreeGLUT window.
@@ -71,6 +78,30 @@ SDL_GLContext *sdl_context;     ///< SDL context.
 GLFWwindow *window;             ///< GLFW window.
 #endif
 GdkGLContext *gdk_gl_context;   ///< Default GdkGLContext.
+static gboolean option_batch = FALSE;
+///< TRUE on running without interface, FALSE otherwise.
+static gboolean option_bench = FALSE;
+///< TRUE on running the benchmark, FALSE otherwise.
+static gboolean option_bench_rng = FALSE;
+///< TRUE on running the random microbenchmark, FALSE otherwise.
+static int option_warmup = BENCH_WARMUP;
+///< Number of warm-up runs of the benchmark.
+static int option_repetitions = BENCH_REPETITIONS;
+///< Number of measured runs of the benchmark.
+static char *option_scaling = NULL;
+///< Scaling sweep type: "strong", "weak" or NULL.
+static char *option_output = NULL;
+///< Results file of the batch mode or the benchmark.
+static char *option_trace = NULL;
+///< Chrome trace JSON file of the threads timeline or NULL.
+#if HAVE_PERF_EVENT
+static gboolean option_perf = FALSE;
+///< TRUE on collecting the hardware performance counters, FALSE otherwise.
+#endif
+#if HAVE_EGL
+static char *option_image = NULL;
+///< PNG file of the final draw of the batch mode or NULL.
+#endif
 
 #if HAVE_GLFW
 void
@@ -80,6 +111,50 @@ glfw_resize (GLFWwindow *win __attribute__((unused)), int w, int h)
 }
 #endif
 
+#if HAVE_EGL
+/**
+ * Function to save the final draw of the batch mode in a PNG file, rendering
+ * on a surfaceless offscreen context.
+ *
+ * \return 1 on success, 0 on error.
+ */
+static int
+main_image (char *file_name)    ///< PNG file name.
+{
+  gint64 span;
+  unsigned int nerrors;
+#if DEBUG
+  printf ("main_image: start\n");
+  fflush (stdout);
+#endif
+  span = g_get_monotonic_time ();
+  snapshot_publish ();
+  if (window_width < width)
+    window_width = width;
+  if (window_height < height)
+    window_height = height;
+  if (!offscreen_open (window_width, window_height))
+    return 0;
+  if (!graphic_init (graphic, "logo.png"))
+    {
+      offscreen_close ();
+      return 0;
+    }
+  graphic_view (graphic, PERSPECTIVE_PHI, PERSPECTIVE_THETA);
+  graphic_render (graphic);
+  graphic_save (graphic, file_name);
+  nerrors = graphic_save_wait (graphic);
+  graphic_destroy (graphic);
+  offscreen_close ();
+  trace_span ("main_image", span);
+#if DEBUG
+  printf ("main_image: end\n");
+  fflush (stdout);
+#endif
+  return !nerrors;
+}
+#endif
+
 /**
  * Function to do one main loop iteration.
  */
@@ -162,7 +237,62 @@ int
 main (int argn,                 ///< Arguments number.
       char **argc)              ///< Array of arguments.
 {
-  if (argn > 2)
+  GOptionEntry options[] = {
+    {"batch", 'b', 0, G_OPTION_ARG_NONE, &option_batch,
+     "Run without interface saving the results on the output file", NULL},
+    {"bench", 0, 0, G_OPTION_ARG_NONE, &option_bench,
+     "Run the benchmark of all the fractal configurations", NULL},
+    {"bench-rng", 0, 0, G_OPTION_ARG_NONE, &option_bench_rng,
+     "Run the microbenchmark of the pseudo-random number generators", NULL},
+    {"scaling", 0, 0, G_OPTION_ARG_STRING, &option_scaling,
+     "Run a strong or weak scaling sweep of the input file", "strong|weak"},
+    {"warmup", 0, 0, G_OPTION_ARG_INT, &option_warmup,
+     "Number of warm-up runs of the benchmark (default: 1)", "N"},
+    {"repetitions", 0, 0, G_OPTION_ARG_INT, &option_repetitions,
+     "Number of measured runs of the benchmark (default: 3)", "N"},
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &option_output,
+     "Results file of the batch mode (default: results), the benchmark "
+     "(default: bench.tsv), the random microbenchmark (default: bench-rng.tsv) "
+     "or the scaling sweep (default: scaling.tsv)", "FILE"},
+    {"report", 'r', 0, G_OPTION_ARG_FILENAME, &report_name,
+     "JSON report file of the simulation runs (default: report.json)",
+     "FILE"},
+    {"metrics", 0, 0, G_OPTION_ARG_FILENAME, &metrics_name,
+     "Live metrics JSON file rewritten every second", "FILE"},
+    {"trace", 0, 0, G_OPTION_ARG_FILENAME, &option_trace,
+     "Save the timeline of the threads on a Chrome trace JSON file", "FILE"},
+#if HAVE_PERF_EVENT
+    {"perf", 0, 0, G_OPTION_ARG_NONE, &option_perf,
+     "Collect the hardware performance counters of the walker threads", NULL},
+#endif
+#if HAVE_EGL
+    {"image", 'i', 0, G_OPTION_ARG_FILENAME, &option_image,
+     "Save the final draw of the batch mode on a PNG file", "FILE"},
+#endif
+    {NULL}
+  };
+  GOptionContext *context;
+  GError *error = NULL;
+
+  // Parsing the command line
+  context = g_option_context_new ("[input file]");
+  g_option_context_add_main_entries (context, options, NULL);
+  g_option_context_set_ignore_unknown_options (context, TRUE);
+  if (!g_option_context_parse (context, &argn, &argc, &error))
+    {
+      printf ("ERROR! %s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  g_option_context_free (context);
+  if (option_scaling && strcmp (option_scaling, "strong")
+      && strcmp (option_scaling, "weak"))
+    {
+      printf ("Bad scaling type\n");
+      return 1;
+    }
+  if (argn > 2 || ((option_batch || option_scaling) && argn != 2)
+      || option_warmup < 0 || option_repetitions < 1)
     {
       printf ("Bad arguments number\n");
       return 1;
@@ -172,6 +302,30 @@ main (int argn,                 ///< Arguments number.
   nthreads = threads_number ();
 // END
 
+  // Opening the trace file
+  if (option_trace)
+    {
+      if (!trace_open (option_trace))
+        {
+          printf ("Unable to open the trace file\n");
+          return 1;
+        }
+      atexit (trace_close);
+    }
+
+#if HAVE_PERF_EVENT
+  // Checking the hardware performance counters
+  if (option_perf)
+    {
+      if (!perf_check ())
+        {
+          printf ("Unable to open the hardware performance counters\n");
+          return 1;
+        }
+      perf = 1;
+    }
+#endif
+
   // Initing locales
 #if DEBUG
   printf ("Initing locales\n");
@@ -183,6 +337,75 @@ main (int argn,                 ///< Arguments number.
   bind_textdomain_codeset ("fractal", "UTF-8");
   textdomain ("fractal");
 
+  // Running the benchmark without interface
+  if (option_bench)
+    {
+#if DEBUG
+      printf ("Running the benchmark\n");
+      fflush (stdout);
+#endif
+      batch = 1;
+      if (argn == 2 && !fractal_input (argc[1]))
+        return 1;
+      if (!bench (option_output ? option_output : "bench.tsv", argn == 2,
+                  option_warmup, option_repetitions))
+        return 1;
+      return 0;
+    }
+
+  // Running the random microbenchmark without interface
+  if (option_bench_rng)
+    {
+#if DEBUG
+      printf ("Running the random microbenchmark\n");
+      fflush (stdout);
+#endif
+      batch = 1;
+      if (argn == 2 && !fractal_input (argc[1]))
+        return 1;
+      if (!bench_rng (option_output ? option_output : "bench-rng.tsv",
+                      argn == 2))
+        return 1;
+      return 0;
+    }
+
+  // Running the scaling sweep without interface
+  if (option_scaling)
+    {
+#if DEBUG
+      printf ("Running the scaling sweep\n");
+      fflush (stdout);
+#endif
+      batch = 1;
+      if (!fractal_input (argc[1]))
+        return 1;
+      if (!bench_scaling (option_output ? option_output : "scaling.tsv",
+                          !strcmp (option_scaling, "weak"), option_warmup,
+                          option_repetitions))
+        return 1;
+      return 0;
+    }
+
+  // Running the simulation without interface
+  if (option_batch)
+    {
+#if DEBUG
+      printf ("Running in batch mode\n");
+      fflush (stdout);
+#endif
+      batch = 1;
+      if (!fractal_input (argc[1]))
+        return 1;
+      fractal ();
+      if (!fractal_results (option_output ? option_output : "results"))
+        return 1;
+#if HAVE_EGL
+      if (option_image && !main_image (option_image))
+        return 1;
+#endif
+      return 0;
+    }
+
   // Initing graphic window
 #if HAVE_FREEGLUT
 
@@ -281,7 +504,7 @@ main (int argn,                 ///< Arguments number.
 
   // Updating view
   if (argn == 2)
-    fractal ();
+    fractal_start ();
   dialog_simulator_update ();
 
   // Main loop
@@ -291,6 +514,14 @@ main (int argn,                 ///< Arguments number.
 #endif
   main_loop ();
 
+  // Stopping the simulation thread
+#if DEBUG
+  printf ("Stopping the simulation thread\n");
+  fflush (stdout);
+#endif
+  fractal_stop ();
+  fractal_join ();
+
   // Freeing memory
   graphic_destroy (graphic);
 #if HAVE_SDL
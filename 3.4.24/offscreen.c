@@ -0,0 +1,183 @@
+/*
+FRACTAL - A program growing fractals to benchmark parallelization and drawing
+libraries.
+
+Copyright 2009-2025, Javier Burguete Tolosa.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY Javier Burguete Tolosa ``AS IS'' AND ANY EXPRESS
+OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+EVENT SHALL Javier Burguete Tolosa OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * \file offscreen.c
+ * \brief Source file to define the surfaceless offscreen drawing functions.
+ * \author Javier Burguete Tolosa.
+ * \copyright Copyright 2009-2025, Javier Burguete Tolosa.
+ */
+#include "config.h"
+#include <stdio.h>
+#if HAVE_EGL
+#include <epoxy/gl.h>
+#include <epoxy/egl.h>
+#endif
+#include "offscreen.h"
+
+#if HAVE_EGL
+
+static EGLDisplay offscreen_display = EGL_NO_DISPLAY;
+///< EGL display without window system.
+static EGLContext offscreen_context = EGL_NO_CONTEXT;
+///< OpenGL context without drawing surface.
+static GLuint offscreen_fbo = 0;        ///< Framebuffer object to draw.
+static GLuint offscreen_rbo = 0;        ///< Color renderbuffer of the draw.
+
+/**
+ * Function to open an OpenGL context without window drawing on a framebuffer
+ * object. It uses the EGL_MESA_platform_surfaceless extension if available,
+ * so it does not need any display server.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+offscreen_open (unsigned int width,     ///< Framebuffer width.
+                unsigned int height)    ///< Framebuffer height.
+{
+  const EGLint attributes[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_ALPHA_SIZE, 8,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint nconfigs;
+  const char *error_message;
+
+#if DEBUG
+  printf ("offscreen_open: start\n");
+  fflush (stdout);
+#endif
+
+  // Opening the display
+  if (epoxy_has_egl_extension (EGL_NO_DISPLAY,
+                               "EGL_MESA_platform_surfaceless"))
+    offscreen_display
+      = eglGetPlatformDisplayEXT (EGL_PLATFORM_SURFACELESS_MESA,
+                                  EGL_DEFAULT_DISPLAY, NULL);
+  else
+    offscreen_display = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+  if (offscreen_display == EGL_NO_DISPLAY)
+    {
+      error_message = "unable to open the EGL display";
+      goto exit_on_error;
+    }
+  if (!eglInitialize (offscreen_display, NULL, NULL))
+    {
+      offscreen_display = EGL_NO_DISPLAY;
+      error_message = "unable to init EGL";
+      goto exit_on_error;
+    }
+
+  // Creating the OpenGL context
+  if (!eglBindAPI (EGL_OPENGL_API))
+    {
+      error_message = "unable to bind the OpenGL API";
+      goto exit_on_error;
+    }
+  if (!eglChooseConfig (offscreen_display, attributes, &config, 1, &nconfigs)
+      || nconfigs < 1)
+    {
+      error_message = "unable to find a valid EGL configuration";
+      goto exit_on_error;
+    }
+  offscreen_context
+    = eglCreateContext (offscreen_display, config, EGL_NO_CONTEXT, NULL);
+  if (offscreen_context == EGL_NO_CONTEXT)
+    {
+      error_message = "unable to create the OpenGL context";
+      goto exit_on_error;
+    }
+  if (!eglMakeCurrent (offscreen_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       offscreen_context))
+    {
+      error_message = "unable to make current the OpenGL context";
+      goto exit_on_error;
+    }
+
+  // Creating the framebuffer object
+  glGenRenderbuffers (1, &offscreen_rbo);
+  glBindRenderbuffer (GL_RENDERBUFFER, offscreen_rbo);
+  glRenderbufferStorage (GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenFramebuffers (1, &offscreen_fbo);
+  glBindFramebuffer (GL_FRAMEBUFFER, offscreen_fbo);
+  glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_RENDERBUFFER, offscreen_rbo);
+  if (glCheckFramebufferStatus (GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+      error_message = "incomplete framebuffer object";
+      goto exit_on_error;
+    }
+  glViewport (0, 0, width, height);
+
+#if DEBUG
+  printf ("offscreen_open: end\n");
+  fflush (stdout);
+#endif
+  return 1;
+
+exit_on_error:
+  printf ("ERROR! Offscreen: %s\n", error_message);
+  offscreen_close ();
+#if DEBUG
+  printf ("offscreen_open: end\n");
+  fflush (stdout);
+#endif
+  return 0;
+}
+
+/**
+ * Function to close the offscreen OpenGL context.
+ */
+void
+offscreen_close ()
+{
+  if (offscreen_context != EGL_NO_CONTEXT)
+    {
+      if (offscreen_fbo)
+        glDeleteFramebuffers (1, &offscreen_fbo);
+      if (offscreen_rbo)
+        glDeleteRenderbuffers (1, &offscreen_rbo);
+      offscreen_fbo = offscreen_rbo = 0;
+      eglMakeCurrent (offscreen_display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                      EGL_NO_CONTEXT);
+      eglDestroyContext (offscreen_display, offscreen_context);
+      offscreen_context = EGL_NO_CONTEXT;
+    }
+  if (offscreen_display != EGL_NO_DISPLAY)
+    {
+      eglTerminate (offscreen_display);
+      offscreen_display = EGL_NO_DISPLAY;
+    }
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*
+FRACTAL - A program growing fractals to benchmark parallelization and drawing
+libraries.
+
+Copyright 2009-2025, Javier Burguete Tolosa.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY Javier Burguete Tolosa ``AS IS'' AND ANY EXPRESS
+OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+EVENT SHALL Javier Burguete Tolosa OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * \file perf.c
+ * \brief Source file to define the hardware performance counters functions.
+ *   The counters of every walker thread are read with the Linux
+ *   perf_event_open system call.
+ * \author Javier Burguete Tolosa.
+ * \copyright Copyright 2009-2025, Javier Burguete Tolosa.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#if HAVE_PERF_EVENT
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "report.h"
+#include "perf.h"
+
+#if HAVE_PERF_EVENT
+
+unsigned int perf = 0;
+///< 1 on collecting the hardware performance counters, 0 otherwise.
+unsigned int perf_available = 0;
+///< Bits of the PerfEvent types available on the CPU.
+unsigned long perf_total[N_PERF_EVENTS];
+///< Hardware performance counters of all the threads in the last run.
+const char *perf_event_name[N_PERF_EVENTS] = {
+  "cycles", "instructions", "l1d-misses", "llc-misses", "dtlb-misses",
+  "branch-misses"
+};                              ///< Array of hardware performance event names.
+
+static const uint32_t perf_event_type[N_PERF_EVENTS] = {
+  PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+  PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+};                              ///< Array of perf_event_open event types.
+static const uint64_t perf_event_config[N_PERF_EVENTS] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_BRANCH_MISSES
+};                              ///< Array of perf_event_open event configs.
+
+/**
+ * Function to check the hardware performance events available on the CPU.
+ *
+ * \return 1 on any available event, 0 otherwise.
+ */
+int
+perf_check ()
+{
+  unsigned long count[N_PERF_EVENTS];
+  int fd[N_PERF_EVENTS];
+  unsigned int i;
+  perf_open (fd);
+  for (i = 0, perf_available = 0; i < N_PERF_EVENTS; ++i)
+    if (fd[i] >= 0)
+      perf_available |= 1 << i;
+  perf_close (fd, count);
+#if DEBUG
+  printf ("perf_check: available=%u\n", perf_available);
+#endif
+  return perf_available != 0;
+}
+
+/**
+ * Function to open and start the hardware performance counters of the
+ * calling thread. The unavailable events get a -1 file descriptor.
+ */
+void
+perf_open (int *fd)             ///< Array of event file descriptors.
+{
+  struct perf_event_attr attr;
+  unsigned int i;
+  for (i = 0; i < N_PERF_EVENTS; ++i)
+    {
+      memset (&attr, 0, sizeof (struct perf_event_attr));
+      attr.size = sizeof (struct perf_event_attr);
+      attr.type = perf_event_type[i];
+      attr.config = perf_event_config[i];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+        | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fd[i] = (int) syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+/**
+ * Function to stop and close the hardware performance counters of the calling
+ * thread adding them to a set of counters. The counts are scaled by the
+ * fraction of time the event was scheduled when the events are multiplexed.
+ */
+void
+perf_close (int *fd,            ///< Array of event file descriptors.
+            unsigned long *count)       ///< Array of counters.
+{
+  uint64_t value[3];
+  unsigned int i;
+  for (i = 0; i < N_PERF_EVENTS; ++i)
+    {
+      if (fd[i] < 0)
+        continue;
+      if (read (fd[i], value, sizeof (value)) == sizeof (value) && value[2])
+        count[i] += (unsigned long)
+          ((double) value[0] * value[1] / value[2]);
+      close (fd[i]);
+    }
+}
+
+/**
+ * Function to save the hardware performance counters per walker step on the
+ * report, null on unavailable events.
+ */
+void
+perf_report (unsigned long steps,       ///< Number of walker steps.
+             unsigned long *count)      ///< Array of counters.
+{
+  char key[32];
+  unsigned int i;
+  report_uint ("steps", steps);
+  for (i = 0; i < N_PERF_EVENTS; ++i)
+    {
+      snprintf (key, 32, "%s/step", perf_event_name[i]);
+      if (perf_available & (1 << i) && steps)
+        report_double (key, (double) count[i] / steps);
+      else
+        report_null (key);
+    }
+}
+
+#endif
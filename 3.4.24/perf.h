@@ -0,0 +1,65 @@
+/*
+FRACTAL - A program growing fractals to benchmark parallelization and drawing
+libraries.
+
+Copyright 2009-2025, Javier Burguete Tolosa.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY Javier Burguete Tolosa ``AS IS'' AND ANY EXPRESS
+OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+EVENT SHALL Javier Burguete Tolosa OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * \file perf.h
+ * \brief Header file to define the hardware performance counters functions.
+ * \author Javier Burguete Tolosa.
+ * \copyright Copyright 2009-2025, Javier Burguete Tolosa.
+ */
+#ifndef PERF__H
+#define PERF__H 1
+
+#if HAVE_PERF_EVENT
+
+///> An enum to define the hardware performance events.
+enum PerfEvent
+{
+  PERF_EVENT_CYCLES = 0,        ///< CPU cycles.
+  PERF_EVENT_INSTRUCTIONS = 1,  ///< Retired instructions.
+  PERF_EVENT_L1D_MISSES = 2,    ///< L1 data cache read misses.
+  PERF_EVENT_LLC_MISSES = 3,    ///< Last level cache read misses.
+  PERF_EVENT_DTLB_MISSES = 4,   ///< Data TLB read misses.
+  PERF_EVENT_BRANCH_MISSES = 5  ///< Branch mispredictions.
+};
+
+#define N_PERF_EVENTS (PERF_EVENT_BRANCH_MISSES + 1)
+  ///< Macro to define the number of hardware performance events.
+
+extern unsigned int perf, perf_available;
+extern unsigned long perf_total[N_PERF_EVENTS];
+extern const char *perf_event_name[N_PERF_EVENTS];
+
+int perf_check ();
+void perf_open (int *fd);
+void perf_close (int *fd, unsigned long *count);
+void perf_report (unsigned long steps, unsigned long *count);
+
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/*
+FRACTAL - A program growing fractals to benchmark parallelization and drawing
+libraries.
+
+Copyright 2009-2025, Javier Burguete Tolosa.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY Javier Burguete Tolosa ``AS IS'' AND ANY EXPRESS
+OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+EVENT SHALL Javier Burguete Tolosa OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * \file report.c
+ * \brief Source file to define the run report functions. The report is saved
+ *   in JSON format through a large buffer, to keep the writes off the
+ *   compute path.
+ * \author Javier Burguete Tolosa.
+ * \copyright Copyright 2009-2025, Javier Burguete Tolosa.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "config2.h"
+#include "report.h"
+
+char *report_name = "report.json";      ///< Report file name.
+static FILE *report_file = NULL;        ///< Report file, NULL on error.
+static char report_buffer[REPORT_BUFFER];       ///< Report file buffer.
+static char report_close_char[REPORT_DEPTH];
+///< Closing characters of the open JSON objects and arrays.
+static unsigned int report_items[REPORT_DEPTH];
+///< Numbers of items of the open JSON objects and arrays.
+static unsigned int report_depth;       ///< Number of open objects and arrays.
+
+/**
+ * Function to save a JSON string escaping the special characters.
+ */
+static void
+report_escape (const char *str) ///< String.
+{
+  putc ('"', report_file);
+  for (; *str; ++str)
+    if (*str == '"' || *str == '\\')
+      fprintf (report_file, "\\%c", *str);
+    else if ((unsigned char) *str < 0x20)
+      fprintf (report_file, "\\u%04x", (unsigned char) *str);
+    else
+      putc (*str, report_file);
+  putc ('"', report_file);
+}
+
+/**
+ * Function to start a JSON item, separating it from the previous one and
+ * saving its key in objects.
+ */
+static void
+report_item (const char *key)   ///< Item key or NULL in arrays.
+{
+  if (report_items[report_depth - 1]++)
+    putc (',', report_file);
+  fprintf (report_file, "\n%*s", 2 * report_depth, "");
+  if (key)
+    {
+      report_escape (key);
+      fprintf (report_file, ": ");
+    }
+}
+
+/**
+ * Function to open a container JSON item.
+ */
+static void
+report_open_item (const char *key,      ///< Item key or NULL in arrays.
+                  char open,    ///< Opening character.
+                  char close)   ///< Closing character.
+{
+  if (!report_file)
+    return;
+  report_item (key);
+  putc (open, report_file);
+  report_close_char[report_depth] = close;
+  report_items[report_depth++] = 0;
+}
+
+/**
+ * Function to open the report file.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+report_open (char *filename)    ///< Report file name.
+{
+#if DEBUG
+  printf ("report_open: start\n");
+#endif
+  report_file = fopen (filename, "w");
+  if (!report_file)
+    return 0;
+  setvbuf (report_file, report_buffer, _IOFBF, REPORT_BUFFER);
+  putc ('{', report_file);
+  report_close_char[0] = '}';
+  report_items[0] = 0;
+  report_depth = 1;
+#if DEBUG
+  printf ("report_open: end\n");
+#endif
+  return 1;
+}
+
+/**
+ * Function to close all the open JSON items and the report file.
+ */
+void
+report_close ()
+{
+  if (!report_file)
+    return;
+  while (report_depth)
+    report_end ();
+  putc ('\n', report_file);
+  fclose (report_file);
+  report_file = NULL;
+}
+
+/**
+ * Function to open a JSON object.
+ */
+void
+report_object (const char *key) ///< Object key or NULL in arrays.
+{
+  report_open_item (key, '{', '}');
+}
+
+/**
+ * Function to open a JSON array.
+ */
+void
+report_array (const char *key)  ///< Array key or NULL in arrays.
+{
+  report_open_item (key, '[', ']');
+}
+
+/**
+ * Function to close the last open JSON object or array.
+ */
+void
+report_end ()
+{
+  if (!report_file || !report_depth)
+    return;
+  --report_depth;
+  if (report_items[report_depth])
+    fprintf (report_file, "\n%*s", 2 * report_depth, "");
+  putc (report_close_char[report_depth], report_file);
+}
+
+/**
+ * Function to save an unsigned integer JSON item.
+ */
+void
+report_uint (const char *key,   ///< Item key or NULL in arrays.
+             unsigned long value)       ///< Value.
+{
+  if (!report_file)
+    return;
+  report_item (key);
+  fprintf (report_file, "%lu", value);
+}
+
+/**
+ * Function to save a floating point JSON item, null if it is not finite.
+ */
+void
+report_double (const char *key, ///< Item key or NULL in arrays.
+               double value)    ///< Value.
+{
+  if (!report_file)
+    return;
+  report_item (key);
+  if (isfinite (value))
+    fprintf (report_file, "%.9g", value);
+  else
+    fprintf (report_file, "null");
+}
+
+/**
+ * Function to save a string JSON item.
+ */
+void
+report_string (const char *key, ///< Item key or NULL in arrays.
+               const char *value)       ///< Value.
+{
+  if (!report_file)
+    return;
+  report_item (key);
+  report_escape (value);
+}
+
+/**
+ * Function to save a null JSON item.
+ */
+void
+report_null (const char *key)   ///< Item key or NULL in arrays.
+{
+  if (!report_file)
+    return;
+  report_item (key);
+  fprintf (report_file, "null");
+}
+
+/**
+ * Function to save the host JSON object: the host name, the CPU model and the
+ * number of cores.
+ */
+void
+report_host (unsigned int cores)        ///< Number of cores.
+{
+  FILE *file;
+  char buffer[256], *value;
+  report_object ("host");
+  report_string ("hostname", g_get_host_name ());
+  file = fopen ("/proc/cpuinfo", "r");
+  if (file)
+    {
+      while (fgets (buffer, 256, file))
+        if (!strncmp (buffer, "model name", 10))
+          {
+            value = strchr (buffer, ':');
+            if (value)
+              report_string ("cpu", g_strstrip (value + 1));
+            break;
+          }
+      fclose (file);
+    }
+  report_uint ("cores", cores);
+  report_end ();
+}
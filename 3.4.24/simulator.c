@@ -37,6 +37,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include <stdatomic.h>
 #include <gsl/gsl_rng.h>
 #include <glib.h>
 #include <libintl.h>
@@ -60,63 +61,65 @@ extern GLFWwindow *window;
 #include "graphic.h"
 #include "draw.h"
 #include "simulator.h"
+#include "trace.h"
 
 #if HAVE_SDL
 SDL_Event exit_event[1];
 #endif
 
-static float phid = -45.;       ///< Horizontal perspective angle (in degrees).
-static float thetad = 80.;      ///< Vertical perspective angle (in degrees).
+static float phid = PERSPECTIVE_PHI;
+///< Horizontal perspective angle (in degrees).
+static float thetad = PERSPECTIVE_THETA;
+///< Vertical perspective angle (in degrees).
+static gint progress_pending = 0;
+///< Number of pending progress messages of the simulation thread.
+static guint perspective_source = 0;
+///< Source of the full detail draw after the last view change, 0 on none.
 
 /**
- * Function the set the perspective of a point.
+ * Function to draw the full detail when the view stops changing.
+ *
+ * \return G_SOURCE_REMOVE.
  */
-static void
-perspective (int x,             ///< Point x-coordinate.
-             int y,             ///< Point y-coordinate.
-             int z,             ///< Point z-coordinate.
-             float *X,          ///< Perspective X-coordinate.
-             float *Y)          ///< Perspective Y-coordinate.
+static gboolean
+set_perspective_end ()
 {
-  float cp, sp, st, ct;
-  sincosf (graphic->phi, &sp, &cp);
-  sincosf (graphic->theta, &st, &ct);
-  *X = x * cp - y * sp;
-  *Y = z * st + (y * cp + x * sp) * ct;
+  perspective_source = 0;
+  graphic->interacting = 0;
+  draw ();
+  return G_SOURCE_REMOVE;
 }
 
 /**
- * Function to set the view perspective.
+ * Function to set the view perspective. While the view is changing a coarse
+ * level of detail is drawn.
  */
 static void
 set_perspective ()
 {
-  float k1, k2;
   phid = gtk_range_get_value (GTK_RANGE (dialog_simulator->hscale));
   thetad = gtk_range_get_value (GTK_RANGE (dialog_simulator->vscale));
-  graphic->phi = phid * M_PI / 180.;
-  graphic->theta = thetad * M_PI / 180.;
-  if (fractal_3D)
-    {
-      perspective (0, 0, 0, &k1, &k2);
-      graphic->xmin = k1;
-      perspective (length, width, 0, &k1, &k2);
-      graphic->xmax = k1;
-      perspective (length, 0, 0, &k1, &k2);
-      graphic->ymin = k2;
-      perspective (0, width, height, &k1, &k2);
-      graphic->ymax = k2;
-    }
+  graphic_view (graphic, phid, thetad);
+  graphic->interacting = 1;
+  if (perspective_source)
+    g_source_remove (perspective_source);
+  perspective_source = g_timeout_add (GRAPHIC_LOD_TIME,
+                                      (GSourceFunc) set_perspective_end, NULL);
   draw ();
 }
 
 /**
- * Function to show an error message
+ * Function to show an error message, on the standard error in batch mode.
  */
 void
 show_error (const char *message)        ///< Error message string.
 {
   GtkMessageDialog *dlg;
+  if (batch)
+    {
+      fprintf (stderr, "%s\n", message);
+      return;
+    }
   dlg = (GtkMessageDialog *)
     gtk_message_dialog_new (dialog_simulator->window,
                             GTK_DIALOG_DESTROY_WITH_PARENT,
@@ -144,6 +147,8 @@ dialog_options_update ()
   i = gtk_check_button_get_active (dlg->button_3D);
   gtk_widget_set_sensitive (GTK_WIDGET (dlg->label_length), i);
   gtk_widget_set_sensitive (GTK_WIDGET (dlg->entry_length), i);
+  i = gtk_check_button_get_active (dlg->button_animate);
+  gtk_widget_set_sensitive (GTK_WIDGET (dlg->button_continuous), i);
   for (i = 0; i < N_RANDOM_SEED_TYPES; ++i)
     if (gtk_check_button_get_active (dlg->array_seeds[i]))
       break;
@@ -177,6 +182,7 @@ dialog_options_close (DialogOptions *dlg,       ///< DialogOptions struct.
       random_seed = gtk_spin_button_get_value_as_int (dlg->entry_seed);
       nthreads = gtk_spin_button_get_value_as_int (dlg->entry_nthreads);
       animating = gtk_check_button_get_active (dlg->button_animate);
+      continuous = gtk_check_button_get_active (dlg->button_continuous);
       for (i = 0; i < N_RANDOM_TYPES; ++i)
         if (gtk_check_button_get_active (dlg->array_algorithms[i]))
           random_algorithm = i;
@@ -184,8 +190,8 @@ dialog_options_close (DialogOptions *dlg,       ///< DialogOptions struct.
         if (gtk_check_button_get_active (dlg->array_seeds[i]))
           random_seed_type = i;
       medium_start ();
+      graphic->update = 1;
       set_perspective ();
-      breaking = 1;
     }
   else if (response_id == GTK_RESPONSE_CANCEL);
   else
@@ -275,6 +281,12 @@ dialog_options_create ()
   dlg->button_animate = (GtkCheckButton *) gtk_check_button_new_with_mnemonic
     (_("_Animate"));
   gtk_check_button_set_active (dlg->button_animate, animating);
+  g_signal_connect (dlg->button_animate, "toggled", dialog_options_update,
+                    NULL);
+
+  dlg->button_continuous = (GtkCheckButton *)
+    gtk_check_button_new_with_mnemonic (_("Contin_uous animation"));
+  gtk_check_button_set_active (dlg->button_continuous, continuous);
 
   dlg->grid_algorithm = (GtkGrid *) gtk_grid_new ();
   dlg->array_algorithms[0] = NULL;
@@ -332,12 +344,13 @@ dialog_options_create ()
   gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->entry_height), 1, 4, 1, 1);
   gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->frame_fractal), 0, 5, 2, 1);
   gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->button_animate), 0, 6, 2, 1);
-  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->frame_algorithm), 2, 0, 1, 8);
-  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->frame_seed), 0, 7, 2, 2);
-  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->label_seed), 0, 9, 1, 1);
-  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->entry_seed), 1, 9, 1, 1);
-  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->label_nthreads), 0, 10, 1, 1);
-  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->entry_nthreads), 1, 10, 1, 1);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->button_continuous), 0, 7, 2, 1);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->frame_algorithm), 2, 0, 1, 9);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->frame_seed), 0, 8, 2, 2);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->label_seed), 0, 10, 1, 1);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->entry_seed), 1, 10, 1, 1);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->label_nthreads), 0, 11, 1, 1);
+  gtk_grid_attach (dlg->grid, GTK_WIDGET (dlg->entry_nthreads), 1, 11, 1, 1);
 
   dlg->logo = (GtkImage *) gtk_image_new_from_file ("logo2.png");
 
@@ -421,60 +434,50 @@ dialog_simulator_update ()
     (GTK_WIDGET (dialog_simulator->button_start), !simulating);
   gtk_widget_set_sensitive
     (GTK_WIDGET (dialog_simulator->button_stop), simulating);
+  gtk_widget_set_sensitive
+    (GTK_WIDGET (dialog_simulator->button_options), !simulating);
   set_perspective ();
 }
 
 /**
- * Function to show the fractal progress.
+ * Function to show the fractal progress. It is called on the main loop as an
+ * idle function.
+ *
+ * \return G_SOURCE_REMOVE.
  */
-void
-dialog_simulator_progress ()
+static gboolean
+dialog_simulator_progress (Progress *progress)  ///< Progress message.
 {
-  GMainContext *context;
-  register unsigned int k;
-  register float x;
-  if (fractal_3D)
+  gint64 span;
+  span = g_get_monotonic_time ();
+  gtk_progress_bar_set_fraction (dialog_simulator->progress,
+                                 progress->fraction);
+  gtk_spin_button_set_value (dialog_simulator->entry_time, progress->time);
+
+  // Drawing only the last pending frame, uploading the new render snapshot
+  graphic->update = 1;
+  if (g_atomic_int_dec_and_test (&progress_pending) || progress->end)
+    draw ();
+
+  if (progress->end)
     {
-      switch (fractal_type)
-        {
-        case 0:
-        case 1:
-          x = max_d / (float) (height - 1);
-          break;
-        default:
-          k = length;
-          if (width < k)
-            k = width;
-          if (height < k)
-            k = height;
-          k = k / 2;
-          if (k)
-            --k;
-          x = fmin (1., max_d / (float) k);
-        }
+      fractal_join ();
+      dialog_simulator_update ();
     }
-  else
-    {
-      switch (fractal_type)
-        {
-        case 0:
-        case 1:
-          x = max_d / (float) (height - 1);
-          break;
-        default:
-          k = width;
-          if (height < k)
-            k = height;
-          k = k / 2 - 1;
-          x = fmin (1., max_d / (float) k);
-        }
-    }
-  gtk_progress_bar_set_fraction (dialog_simulator->progress, x);
-  gtk_spin_button_set_value
-    (dialog_simulator->entry_time, difftime (time (NULL), t0));
-  context = g_main_context_default ();
-  while (g_main_context_pending (context))
-    g_main_context_iteration (context, 0);
+  g_slice_free1 (sizeof (Progress), progress);
+  trace_span ("dialog_simulator_progress", span);
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * Function to post a fractal progress message from the simulation thread to
+ * the main loop.
+ */
+void
+dialog_simulator_post (Progress *progress)      ///< Progress message.
+{
+  g_atomic_int_inc (&progress_pending);
+  g_idle_add ((GSourceFunc) dialog_simulator_progress, progress);
 }
 
 /**
@@ -486,6 +489,7 @@ dialog_simulator_graphic_close (GtkFileChooserDialog *dlg,
                                 int response_id)        ///< Response identifier.
 {
   char *filename;
+  gint64 span;
   if (response_id == GTK_RESPONSE_ACCEPT)
     filename = gtk_file_chooser_get_current_name (GTK_FILE_CHOOSER (dlg));
   else
@@ -497,7 +501,9 @@ dialog_simulator_graphic_close (GtkFileChooserDialog *dlg,
 #endif
   if (filename)
     {
-      graphic_save (filename);
+      span = g_get_monotonic_time ();
+      graphic_save (graphic, filename);
+      trace_span ("graphic_save", span);
       g_free (filename);
     }
 }
@@ -614,7 +620,7 @@ dialog_simulator_create ()
 #endif
   gtk_widget_set_tooltip_text (GTK_WIDGET (dlg->button_start), tip_start);
   gtk_box_append (dlg->box, GTK_WIDGET (dlg->button_start));
-  g_signal_connect (dlg->button_start, "clicked", fractal, NULL);
+  g_signal_connect (dlg->button_start, "clicked", fractal_start, NULL);
 
   dlg->button_stop = (GtkButton *)
 #if !GTK4
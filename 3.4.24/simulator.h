@@ -62,6 +62,8 @@ typedef struct
   ///< GtkButton to set 2D / 3D fractals.
   GtkCheckButton *button_animate;
   ///< GtkButton to set graphical animation.
+  GtkCheckButton *button_continuous;
+  ///< GtkButton to set graphical animation without stopping the threads.
 #if !GTK4
   GtkRadioButton *array_fractals[N_FRACTAL_TYPES];
   ///< Array of GtkRadioButtons to set the fractal type.
@@ -142,7 +144,7 @@ extern DialogSimulator dialog_simulator[1];
 void show_error (const char *message);
 
 void dialog_simulator_update ();
-void dialog_simulator_progress ();
+void dialog_simulator_post (Progress *progress);
 void dialog_simulator_create ();
 
 #endif
@@ -35,6 +35,7 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <glib.h>
 #include <png.h>
@@ -46,6 +47,102 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "image.h"
 #include "text.h"
 
+/**
+ * Function to rasterize the characters in a glyphs atlas texture. Every glyph
+ * is stored on a cell of a grid with a blank pixel border to avoid bleeding
+ * on linear filtering.
+ *
+ * \return 1 on success, 0 on error.
+ */
+static int
+text_atlas (Text *text,         ///< Text struct data.
+            const char **error_message) ///< Error message.
+{
+  FT_Library ft;
+  FT_Face face;
+  FT_Bitmap *bitmap;
+  Glyph *g;
+  GLubyte *atlas;
+  unsigned int i, j, x, y, cell_width, cell_height, atlas_width, atlas_height,
+    atlas_size;
+
+  // Initing FreeType
+  if (FT_Init_FreeType (&ft))
+    {
+      *error_message = "could not init freetype library";
+      return 0;
+    }
+  if (FT_New_Face (ft, FONT, 0, &face))
+    {
+      FT_Done_Library (ft);
+      *error_message = "could not open font";
+      return 0;
+    }
+  FT_Set_Pixel_Sizes (face, 0, TEXT_SIZE);
+
+  // Getting the glyphs metrics and the cells size
+  cell_width = cell_height = 0;
+  for (i = 0; i < TEXT_NGLYPHS; ++i)
+    {
+      g = text->glyph + i;
+      if (FT_Load_Char (face, TEXT_FIRST_CHAR + i, FT_LOAD_RENDER))
+        {
+          memset (g, 0, sizeof (Glyph));
+          continue;
+        }
+      g->left = face->glyph->bitmap_left;
+      g->top = face->glyph->bitmap_top;
+      g->advance_x = face->glyph->advance.x >> 6;
+      g->advance_y = face->glyph->advance.y >> 6;
+      g->width = face->glyph->bitmap.width;
+      g->rows = face->glyph->bitmap.rows;
+      if (g->width + 2 > cell_width)
+        cell_width = g->width + 2;
+      if (g->rows + 2 > cell_height)
+        cell_height = g->rows + 2;
+    }
+  atlas_width = TEXT_ATLAS_COLUMNS * cell_width;
+  atlas_height = ((TEXT_NGLYPHS + TEXT_ATLAS_COLUMNS - 1) / TEXT_ATLAS_COLUMNS)
+    * cell_height;
+  atlas_size = atlas_width * atlas_height;
+  atlas = (GLubyte *) g_slice_alloc0 (atlas_size);
+
+  // Rasterizing the glyphs
+  for (i = 0; i < TEXT_NGLYPHS; ++i)
+    {
+      g = text->glyph + i;
+      if (!g->width || FT_Load_Char (face, TEXT_FIRST_CHAR + i, FT_LOAD_RENDER))
+        continue;
+      bitmap = &face->glyph->bitmap;
+      x = (i % TEXT_ATLAS_COLUMNS) * cell_width + 1;
+      y = (i / TEXT_ATLAS_COLUMNS) * cell_height + 1;
+      for (j = 0; j < g->rows; ++j)
+        memcpy (atlas + (y + j) * atlas_width + x,
+                bitmap->buffer + j * bitmap->pitch, g->width);
+      g->s[0] = ((GLfloat) x) / atlas_width;
+      g->s[1] = ((GLfloat) (x + g->width)) / atlas_width;
+      g->t[0] = ((GLfloat) y) / atlas_height;
+      g->t[1] = ((GLfloat) (y + g->rows)) / atlas_height;
+    }
+  FT_Done_Face (face);
+  FT_Done_Library (ft);
+
+  // Uploading the atlas texture
+  glActiveTexture (GL_TEXTURE0);
+  glGenTextures (1, &text->texture);
+  glBindTexture (GL_TEXTURE_2D, text->texture);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D (GL_TEXTURE_2D, 0, GL_ALPHA, atlas_width, atlas_height, 0,
+                GL_ALPHA, GL_UNSIGNED_BYTE, atlas);
+  glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+  g_slice_free1 (atlas_size, atlas);
+  return 1;
+}
+
 /**
  * Function to init the variables used to draw text.
  *
@@ -129,20 +226,27 @@ text_init (Text *text)          ///< Text struct data.
       goto exit_on_error;
     }
 
-  // Initing FreeType
-  if (FT_Init_FreeType (&text->ft))
-    {
-      error_message = "could not init freetype library";
-      goto exit_on_error;
-    }
-  if (FT_New_Face (text->ft, FONT, 0, &text->face))
-    {
-      error_message = "could not open font";
-      goto exit_on_error;
-    }
-  FT_Set_Pixel_Sizes (text->face, 0, 12);
+  // Building the glyphs atlas
+  if (!text_atlas (text, &error_message))
+    goto exit_on_error;
 
+  // The texture unit and the vertex attributes are constant
+  glUseProgram (text->program);
+  glUniform1i (text->uniform_text, 0);
+  text->vertices = NULL;
+  text->nallocated = 0;
   glGenBuffers (1, &text->vbo);
+  text->vao = 0;
+  if (GL_HAVE_VAO)
+    {
+      glGenVertexArrays (1, &text->vao);
+      glBindVertexArray (text->vao);
+      glBindBuffer (GL_ARRAY_BUFFER, text->vbo);
+      glEnableVertexAttribArray (text->attribute_position);
+      glVertexAttribPointer (text->attribute_position, 4, GL_FLOAT, GL_FALSE,
+                             0, 0);
+      glBindVertexArray (0);
+    }
   return 1;
 
 exit_on_error:
@@ -161,9 +265,12 @@ text_destroy (Text *text)       ///< Text struct data.
   fflush (stdout);
 #endif
 
+  if (text->vao)
+    glDeleteVertexArrays (1, &text->vao);
+  glDeleteBuffers (1, &text->vbo);
+  glDeleteTextures (1, &text->texture);
   glDeleteProgram (text->program);
-  FT_Done_Face (text->face);
-  FT_Done_Library (text->ft);
+  g_free (text->vertices);
 
 #if DEBUG
   printf ("text_destroy: end\n");
@@ -183,67 +290,85 @@ text_draw (Text *text,          ///< Text struct data.
            float sy,            ///< y scale factor.
            const GLfloat *color)        ///< array of RBGA colors.
 {
-  float box[16];
-  FT_Face face;
+  Glyph *g;
+  GLfloat *v;
   float x2, y2, w, h;
-  GLuint id;
+  unsigned int c, n;
 
 #if DEBUG
   printf ("text_draw: start\n");
   fflush (stdout);
 #endif
 
+  // Filling two triangles per visible character
+  n = strlen (string);
+  if (n > text->nallocated)
+    {
+      text->nallocated = n;
+      text->vertices
+        = (GLfloat *) g_realloc (text->vertices, n * 24 * sizeof (GLfloat));
+    }
+  v = text->vertices;
+  for (; *string; ++string)
+    {
+      c = (unsigned char) *string - TEXT_FIRST_CHAR;
+      if (c >= TEXT_NGLYPHS)
+        continue;
+      g = text->glyph + c;
+      if (g->width && g->rows)
+        {
+          x2 = x + g->left * sx;
+          y2 = y + g->top * sy;
+          w = g->width * sx;
+          h = g->rows * sy;
+          v[0] = v[12] = x2;
+          v[1] = v[13] = y2;
+          v[2] = v[14] = g->s[0];
+          v[3] = v[15] = g->t[0];
+          v[4] = v[16] = x2 + w;
+          v[5] = v[17] = y2 - h;
+          v[6] = v[18] = g->s[1];
+          v[7] = v[19] = g->t[1];
+          v[8] = x2 + w;
+          v[9] = y2;
+          v[10] = g->s[1];
+          v[11] = g->t[0];
+          v[20] = x2;
+          v[21] = y2 - h;
+          v[22] = g->s[0];
+          v[23] = g->t[1];
+          v += 24;
+        }
+      x += g->advance_x * sx;
+      y += g->advance_y * sy;
+    }
+  n = (v - text->vertices) / 4;
+  if (!n)
+    goto end_draw;
+
+  // Drawing all the characters in a call
   glUseProgram (text->program);
-  glGenTextures (1, &id);
-  glBindTexture (GL_TEXTURE_2D, id);
-  glUniform1i (text->uniform_text, 0);
-  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
   glUniform4fv (text->uniform_color, 1, color);
-  glEnableVertexAttribArray (text->attribute_position);
+  glBindTexture (GL_TEXTURE_2D, text->texture);
   glBindBuffer (GL_ARRAY_BUFFER, text->vbo);
-  glVertexAttribPointer (text->attribute_position, 4, GL_FLOAT, GL_FALSE, 0, 0);
-  face = text->face;
-  box[2] = 0.f;
-  box[3] = 0.f;
-  box[6] = 1.f;
-  box[7] = 0.f;
-  box[10] = 0.f;
-  box[11] = 1.f;
-  box[14] = 1.f;
-  box[15] = 1.f;
-  for (; *string; ++string)
+  glBufferData (GL_ARRAY_BUFFER, n * 4 * sizeof (GLfloat), text->vertices,
+                GL_STREAM_DRAW);
+  if (text->vao)
     {
-      if (FT_Load_Char (face, *string, FT_LOAD_RENDER))
-        continue;
-      glTexImage2D (GL_TEXTURE_2D,
-                    0,
-                    GL_ALPHA,
-                    face->glyph->bitmap.width,
-                    face->glyph->bitmap.rows,
-                    0, GL_ALPHA, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
-      x2 = x + face->glyph->bitmap_left * sx;
-      y2 = -y - face->glyph->bitmap_top * sy;
-      w = face->glyph->bitmap.width * sx;
-      h = face->glyph->bitmap.rows * sy;
-      box[0] = x2;
-      box[1] = -y2;
-      box[4] = x2 + w;
-      box[5] = -y2;
-      box[8] = x2;
-      box[9] = -y2 - h;
-      box[12] = x2 + w;
-      box[13] = -y2 - h;
-      glBufferData (GL_ARRAY_BUFFER, sizeof (box), box, GL_DYNAMIC_DRAW);
-      glDrawArrays (GL_TRIANGLE_STRIP, 0, 4);
-      x += (face->glyph->advance.x >> 6) * sx;
-      y += (face->glyph->advance.y >> 6) * sy;
+      glBindVertexArray (text->vao);
+      glDrawArrays (GL_TRIANGLES, 0, n);
+      glBindVertexArray (0);
+    }
+  else
+    {
+      glEnableVertexAttribArray (text->attribute_position);
+      glVertexAttribPointer (text->attribute_position, 4, GL_FLOAT, GL_FALSE,
+                             0, 0);
+      glDrawArrays (GL_TRIANGLES, 0, n);
+      glDisableVertexAttribArray (text->attribute_position);
     }
-  glDisableVertexAttribArray (text->attribute_position);
 
+end_draw:
 #if DEBUG
   printf ("text_draw: end\n");
   fflush (stdout);
@@ -35,18 +35,42 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef TEXT__H
 #define TEXT__H 1
 
+#define TEXT_FIRST_CHAR 32
+///< Macro to set the first character of the glyphs atlas.
+#define TEXT_NGLYPHS 95
+///< Macro to set the number of characters of the glyphs atlas.
+
+/**
+ * \struct Glyph
+ * Struct to define the metrics of a glyph on the atlas.
+ */
+typedef struct
+{
+  GLfloat s[2];                 ///< Horizontal texture coordinates.
+  GLfloat t[2];                 ///< Vertical texture coordinates.
+  int left;                     ///< Horizontal bearing (pixels).
+  int top;                      ///< Vertical bearing (pixels).
+  int advance_x;                ///< Horizontal advance (pixels).
+  int advance_y;                ///< Vertical advance (pixels).
+  unsigned int width;           ///< Bitmap width (pixels).
+  unsigned int rows;            ///< Bitmap height (pixels).
+} Glyph;
+
 /**
  * \struct Text
  * Struct to define data to draw text.
  */
 typedef struct
 {
-  FT_Library ft;                ///< FreeType data.
-  FT_Face face;                 ///< FreeType face to draw text.
+  Glyph glyph[TEXT_NGLYPHS];    ///< Glyphs metrics.
+  GLfloat *vertices;            ///< Array of the quads of a string.
+  unsigned int nallocated;      ///< Number of characters allocated on vertices.
   GLint attribute_position;     ///< Text variable position.
   GLint uniform_text;           ///< Text constant.
   GLint uniform_color;          ///< Color constant.
+  GLuint texture;               ///< Glyphs atlas texture.
   GLuint vbo;                   ///< Text vertex buffer object.
+  GLuint vao;                   ///< Text vertex array (0 if unavailable).
   GLuint program;               ///< Text program.
 } Text;
 
@@ -0,0 +1,147 @@
+/*
+FRACTAL - A program growing fractals to benchmark parallelization and drawing
+libraries.
+
+Copyright 2009-2025, Javier Burguete Tolosa.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY Javier Burguete Tolosa ``AS IS'' AND ANY EXPRESS
+OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+EVENT SHALL Javier Burguete Tolosa OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * \file trace.c
+ * \brief Source file to define the timeline trace functions. The trace is
+ *   saved in the Chrome trace JSON format, to be opened with Perfetto or
+ *   chrome://tracing.
+ * \author Javier Burguete Tolosa.
+ * \copyright Copyright 2009-2025, Javier Burguete Tolosa.
+ */
+#include "config.h"
+#include <stdio.h>
+#include <glib.h>
+#include "trace.h"
+
+static FILE *trace_file = NULL; ///< Trace file, NULL on not tracing.
+static gint64 trace_start;
+///< Monotonic start time of the trace (microseconds).
+static unsigned int trace_events;       ///< Number of saved events.
+static GMutex trace_mutex[1];   ///< Mutex to lock the trace file writes.
+static _Thread_local unsigned int trace_tid = TRACE_THREAD_MAIN;
+///< Trace identifier of the thread.
+
+/**
+ * Function to start a trace event, separating it from the previous one.
+ */
+static inline void
+trace_event ()
+{
+  if (trace_events++)
+    fprintf (trace_file, ",\n");
+}
+
+/**
+ * Function to open the trace file.
+ *
+ * \return 1 on success, 0 on error.
+ */
+int
+trace_open (char *filename)     ///< Trace file name.
+{
+#if DEBUG
+  printf ("trace_open: start\n");
+#endif
+  trace_file = fopen (filename, "w");
+  if (!trace_file)
+    return 0;
+  trace_start = g_get_monotonic_time ();
+  trace_events = 0;
+  fprintf (trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  trace_name (TRACE_THREAD_MAIN, "main");
+  trace_name (TRACE_THREAD_FRACTAL, "fractal");
+#if DEBUG
+  printf ("trace_open: end\n");
+#endif
+  return 1;
+}
+
+/**
+ * Function to close the trace file.
+ */
+void
+trace_close ()
+{
+  if (!trace_file)
+    return;
+  g_mutex_lock (trace_mutex);
+  fprintf (trace_file, "\n]}\n");
+  fclose (trace_file);
+  trace_file = NULL;
+  g_mutex_unlock (trace_mutex);
+}
+
+/**
+ * Function to name a thread on the trace.
+ */
+void
+trace_name (unsigned int tid,   ///< Thread identifier.
+            const char *name)   ///< Thread name.
+{
+  if (!trace_file)
+    return;
+  g_mutex_lock (trace_mutex);
+  trace_event ();
+  fprintf (trace_file,
+           "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+           "\"args\":{\"name\":\"%s\"}}", tid, name);
+  g_mutex_unlock (trace_mutex);
+}
+
+/**
+ * Function to set the trace identifier of the current thread.
+ */
+void
+trace_thread (unsigned int tid) ///< Thread identifier.
+{
+  trace_tid = tid;
+}
+
+/**
+ * Function to save a span of the current thread from a start time to now.
+ */
+void
+trace_span (const char *name,   ///< Span name.
+            gint64 start)       ///< Monotonic start time (microseconds).
+{
+  gint64 end;
+  if (!trace_file)
+    return;
+  end = g_get_monotonic_time ();
+  g_mutex_lock (trace_mutex);
+  if (trace_file)
+    {
+      trace_event ();
+      fprintf (trace_file,
+               "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+               "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT "}",
+               name, trace_tid, start - trace_start, end - start);
+    }
+  g_mutex_unlock (trace_mutex);
+}